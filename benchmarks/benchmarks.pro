@@ -0,0 +1,23 @@
+
+QT       += core gui printsupport concurrent network testlib
+
+greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
+
+TARGET = TextrBenchmarks
+TEMPLATE = app
+
+DEFINES += QT_DEPRECATED_WARNINGS
+CONFIG += c++11 console
+CONFIG -= app_bundle
+
+
+include(../src/textr.pri)
+
+SOURCES += \
+    corpus.cpp \
+    editorbenchmark.cpp \
+    main.cpp
+
+HEADERS += \
+    corpus.h \
+    editorbenchmark.h
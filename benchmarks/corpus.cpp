@@ -0,0 +1,166 @@
+#include "corpus.h"
+#include <climits>
+
+
+namespace
+{
+    const char *CPP_TEMPLATE =
+        "namespace module%1\n"
+        "{\n"
+        "    // Computes the running value for item %1\n"
+        "    int compute%1(const std::vector<int> &values)\n"
+        "    {\n"
+        "        int value = 0;\n"
+        "        for (int i = 0; i < values.size(); i++)\n"
+        "        {\n"
+        "            if (values[i] > %1)\n"
+        "            {\n"
+        "                value += values[i] * 3;\n"
+        "            }\n"
+        "        }\n"
+        "        /* The result is cached\n"
+        "           by the caller */\n"
+        "        return value;\n"
+        "    }\n"
+        "}\n\n";
+
+    const char *JAVA_TEMPLATE =
+        "public class Item%1 extends BaseItem\n"
+        "{\n"
+        "    private int value = %1;\n\n"
+        "    // Returns the running value for item %1\n"
+        "    public int compute(int[] values)\n"
+        "    {\n"
+        "        for (int i = 0; i < values.length; i++)\n"
+        "        {\n"
+        "            value += values[i] > %1 ? values[i] : 0;\n"
+        "        }\n"
+        "        return value;\n"
+        "    }\n"
+        "}\n\n";
+
+    const char *PYTHON_TEMPLATE =
+        "class Item%1(BaseItem):\n"
+        "    \"\"\"Running value for item %1.\"\"\"\n\n"
+        "    def compute(self, values):\n"
+        "        value = 0\n"
+        "        for item in values:\n"
+        "            if item > %1:\n"
+        "                value += item * 3  # weighted\n"
+        "        return value\n\n\n";
+
+    const char *LOG_TEMPLATE =
+        "2024-03-%2 12:%3:%4.%1 INFO  [worker-%3] request id=%1 path=/api/items/%1 status=200 value=%1\n"
+        "2024-03-%2 12:%3:%4.%1 DEBUG [worker-%3] cache miss for key item:%1\n";
+
+    const char *ASCII_TEMPLATE =
+        "The quick brown fox jumps over the lazy dog while value %1 is computed and saved.\n"
+        "Editors should stay responsive when a document grows past a few megabytes.\n";
+
+    const char *UNICODE_TEMPLATE =
+        "Съешь же ещё этих мягких французских булок, да выпей чаю %1.\n"
+        "Ελληνικά κείμενα, 日本語のテキスト, and emoji 🚀✨ mixed with value %1.\n";
+
+
+    // Подставляет номер повторения; шаблон журнала дополнительно получает день, минуты и секунды
+    QString fill(const QString &pattern, int index)
+    {
+        QString text = QString(pattern).arg(index);
+
+        if (text.contains("%2"))
+        {
+            text = text.arg(index % 28 + 1, 2, 10, QChar('0')).arg(index % 60, 2, 10, QChar('0'))
+                       .arg(index * 7 % 60, 2, 10, QChar('0'));
+        }
+
+        return text;
+    }
+}
+
+
+/* Повторяет шаблон вида kind с растущим номером, пока текст не достигнет length символов,
+   и обрезает его по последнему переводу строки.
+ */
+QString Corpus::generate(Kind kind, qint64 length)
+{
+    const char *pattern = ASCII_TEMPLATE;
+
+    switch (kind)
+    {
+        case AsciiText: pattern = ASCII_TEMPLATE; break;
+        case UnicodeText: pattern = UNICODE_TEMPLATE; break;
+        case CppSource: pattern = CPP_TEMPLATE; break;
+        case JavaSource: pattern = JAVA_TEMPLATE; break;
+        case PythonSource: pattern = PYTHON_TEMPLATE; break;
+        case Log: pattern = LOG_TEMPLATE; break;
+    }
+
+    QString templateText = QString::fromUtf8(pattern);
+    QString text;
+    text.reserve(int(qMin<qint64>(length + templateText.length() * 2, INT_MAX / 2)));
+
+    for (int index = 0; text.length() < length; index++)
+    {
+        text += fill(templateText, index);
+    }
+
+    int lastNewline = text.lastIndexOf('\n', int(length) - 1);
+    text.truncate(lastNewline > 0 ? lastNewline + 1 : int(length));
+    return text;
+}
+
+
+QString Corpus::kindName(Kind kind)
+{
+    switch (kind)
+    {
+        case AsciiText: return "ascii";
+        case UnicodeText: return "unicode";
+        case CppSource: return "cpp";
+        case JavaSource: return "java";
+        case PythonSource: return "python";
+        case Log: return "log";
+    }
+
+    return QString();
+}
+
+
+QString Corpus::sizeName(qint64 length)
+{
+    if (length >= (1 << 30))
+    {
+        return QString("%1GB").arg(length >> 30);
+    }
+    if (length >= (1 << 20))
+    {
+        return QString("%1MB").arg(length >> 20);
+    }
+    return QString("%1KB").arg(length >> 10);
+}
+
+
+/* Размеры корпусов, не превышающие TEXTR_BENCH_MAX_SIZE (по умолчанию DEFAULT_MAX_LENGTH).
+   Корпус, не помещающийся в один QString, пропускается: редактор тоже читает файл целиком в строку.
+ */
+QVector<qint64> Corpus::lengths()
+{
+    bool ok = false;
+    qint64 maxLength = qEnvironmentVariable("TEXTR_BENCH_MAX_SIZE").toLongLong(&ok);
+    if (!ok)
+    {
+        maxLength = DEFAULT_MAX_LENGTH;
+    }
+
+    QVector<qint64> lengths;
+    for (qint64 length : {qint64(1) << 10, qint64(64) << 10, qint64(1) << 20, qint64(16) << 20,
+                          qint64(256) << 20, qint64(1) << 30})
+    {
+        if (length <= maxLength && length < MAX_STRING_LENGTH)
+        {
+            lengths.append(length);
+        }
+    }
+
+    return lengths;
+}
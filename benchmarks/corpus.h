@@ -0,0 +1,33 @@
+#ifndef CORPUS_H
+#define CORPUS_H
+#include <QString>
+#include <QVector>
+#include <climits>
+
+
+/* Генерация тестовых корпусов для бенчмарков. Текст детерминирован: один и тот же вид
+   и размер всегда дают одинаковое содержимое, поэтому результаты сравнимы между версиями.
+ */
+namespace Corpus
+{
+    enum Kind
+    {
+        AsciiText,
+        UnicodeText,
+        CppSource,
+        JavaSource,
+        PythonSource,
+        Log
+    };
+
+    QString generate(Kind kind, qint64 length);
+    QString kindName(Kind kind);
+    QString sizeName(qint64 length);
+    QVector<qint64> lengths();
+
+    // Размеры от 1 КБ до 1 ГБ; большие размеры включаются через TEXTR_BENCH_MAX_SIZE (в байтах)
+    const qint64 DEFAULT_MAX_LENGTH = 16 << 20;
+    const qint64 MAX_STRING_LENGTH = (qint64(INT_MAX) - 64) / 2;
+}
+
+#endif // CORPUS_H
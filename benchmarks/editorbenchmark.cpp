@@ -0,0 +1,379 @@
+#include "editorbenchmark.h"
+#include "editor.h"
+#include "mainwindow.h"
+#include "tabbededitor.h"
+#include "code_highlighters/chighlighter.h"
+#include "code_highlighters/cpphighlighter.h"
+#include "code_highlighters/javahighlighter.h"
+#include "code_highlighters/pythonhighlighter.h"
+#include <QtTest>
+#include <QFile>
+#include <QTextStream>
+#include <QTextDocument>
+#include <QPlainTextDocumentLayout>
+#include <QTextCursor>
+#include <QScopedPointer>
+
+
+namespace
+{
+    const int TABS_TO_SWITCH = 8;
+
+    Language languageOf(Corpus::Kind kind)
+    {
+        switch (kind)
+        {
+            case Corpus::CppSource: return Language::CPP;
+            case Corpus::JavaSource: return Language::Java;
+            case Corpus::PythonSource: return Language::Python;
+            default: return Language::None;
+        }
+    }
+}
+
+
+void EditorBenchmark::initTestCase()
+{
+    QVERIFY(directory.isValid());
+}
+
+
+// Добавляет строки данных "вид/размер" для указанных видов корпуса и всех доступных размеров.
+void EditorBenchmark::addCorpusRows(const QVector<Corpus::Kind> &kinds)
+{
+    QTest::addColumn<int>("kind");
+    QTest::addColumn<qint64>("length");
+
+    for (Corpus::Kind kind : kinds)
+    {
+        for (qint64 length : Corpus::lengths())
+        {
+            QTest::addRow("%s/%s", qPrintable(Corpus::kindName(kind)), qPrintable(Corpus::sizeName(length)))
+                << int(kind) << length;
+        }
+    }
+}
+
+
+void EditorBenchmark::addAllCorpusRows()
+{
+    addCorpusRows({Corpus::AsciiText, Corpus::UnicodeText, Corpus::CppSource,
+                   Corpus::JavaSource, Corpus::PythonSource, Corpus::Log});
+}
+
+
+/* Текст корпуса текущей строки данных. Последний сгенерированный корпус кэшируется:
+   строки одного бенчмарка идут подряд, а генерация больших корпусов дорога.
+ */
+QString EditorBenchmark::corpusText()
+{
+    QFETCH(int, kind);
+    QFETCH(qint64, length);
+
+    static QPair<int, qint64> cachedKey(-1, 0);
+    static QString cachedText;
+
+    if (cachedKey != qMakePair(kind, length))
+    {
+        cachedText.clear();
+        cachedText = Corpus::generate(Corpus::Kind(kind), length);
+        cachedKey = qMakePair(kind, length);
+    }
+
+    return cachedText;
+}
+
+
+// Путь к файлу с корпусом текущей строки данных во временном каталоге (UTF-8).
+QString EditorBenchmark::corpusFile()
+{
+    QString filePath = directory.filePath(QString(QTest::currentDataTag()).replace('/', '_') + ".txt");
+
+    if (!QFile::exists(filePath))
+    {
+        QFile file(filePath);
+        file.open(QIODevice::WriteOnly | QFile::Text);
+        QTextStream out(&file);
+        out << corpusText();
+    }
+
+    return filePath;
+}
+
+
+void EditorBenchmark::openFile_data()
+{
+    addAllCorpusRows();
+}
+
+
+// Те же шаги, что и MainWindow::on_actionOpen_triggered после выбора файла.
+void EditorBenchmark::openFile()
+{
+    QString filePath = corpusFile();
+
+    QBENCHMARK
+    {
+        Editor editor;
+        QFile file(filePath);
+        QVERIFY(file.open(QIODevice::ReadOnly | QFile::Text));
+        QTextStream in(&file);
+        editor.setPlainText(in.readAll());
+    }
+}
+
+
+void EditorBenchmark::saveFile_data()
+{
+    addAllCorpusRows();
+}
+
+
+// Те же шаги, что и MainWindow::on_actionSaveTriggered после выбора пути.
+void EditorBenchmark::saveFile()
+{
+    Editor editor;
+    editor.setPlainText(corpusText());
+    QString filePath = directory.filePath("saved.txt");
+
+    QBENCHMARK
+    {
+        QFile file(filePath);
+        QVERIFY(file.open(QIODevice::WriteOnly | QFile::Text));
+        QTextStream out(&file);
+        out << editor.toPlainText();
+    }
+}
+
+
+void EditorBenchmark::updateWordCount_data()
+{
+    addAllCorpusRows();
+}
+
+
+void EditorBenchmark::updateWordCount()
+{
+    Editor editor;
+    editor.setPlainText(corpusText());
+
+    QBENCHMARK
+    {
+        editor.updateWordCount();
+    }
+}
+
+
+void EditorBenchmark::highlight_data()
+{
+    QTest::addColumn<int>("kind");
+    QTest::addColumn<qint64>("length");
+    QTest::addColumn<int>("language");
+
+    struct Row { const char *name; Corpus::Kind kind; Language language; };
+    const Row rows[] = {
+        {"c", Corpus::CppSource, Language::C},
+        {"cpp", Corpus::CppSource, Language::CPP},
+        {"java", Corpus::JavaSource, Language::Java},
+        {"python", Corpus::PythonSource, Language::Python},
+    };
+
+    for (const Row &row : rows)
+    {
+        for (qint64 length : Corpus::lengths())
+        {
+            QTest::addRow("%s/%s", row.name, qPrintable(Corpus::sizeName(length)))
+                << int(row.kind) << length << int(row.language);
+        }
+    }
+}
+
+
+// Полная переподсветка документа каждым подклассом Highlighter.
+void EditorBenchmark::highlight()
+{
+    QFETCH(int, language);
+
+    QTextDocument document(corpusText());
+    document.setDocumentLayout(new QPlainTextDocumentLayout(&document));
+
+    QScopedPointer<Highlighter> highlighter;
+    switch (Language(language))
+    {
+        case Language::C: highlighter.reset(new CHighlighter(&document)); break;
+        case Language::CPP: highlighter.reset(new CPPHighlighter(&document)); break;
+        case Language::Java: highlighter.reset(new JavaHighlighter(&document)); break;
+        case Language::Python: highlighter.reset(new PythonHighlighter(&document)); break;
+        default: QSKIP("No highlighter for this language");
+    }
+
+    QBENCHMARK
+    {
+        highlighter->rehighlight();
+    }
+}
+
+
+void EditorBenchmark::find_data()
+{
+    addAllCorpusRows();
+}
+
+
+// Поиск отсутствующей строки: худший случай, документ просматривается дважды (до конца и с начала).
+void EditorBenchmark::find()
+{
+    Editor editor;
+    editor.setPlainText(corpusText());
+
+    QBENCHMARK
+    {
+        editor.find("textr_benchmark_missing", true, false);
+    }
+}
+
+
+void EditorBenchmark::replaceAll_data()
+{
+    addAllCorpusRows();
+}
+
+
+// Замена туда и обратно, чтобы каждая итерация работала с одним и тем же документом.
+void EditorBenchmark::replaceAll()
+{
+    Editor editor;
+    editor.setPlainText(corpusText());
+
+    QBENCHMARK
+    {
+        editor.replaceAll("value", "qqvalue", true, true);
+        editor.replaceAll("qqvalue", "value", true, true);
+    }
+}
+
+
+void EditorBenchmark::indentSelection_data()
+{
+    addAllCorpusRows();
+}
+
+
+// Отступ всего выделенного документа; отмена возвращает документ к исходному состоянию.
+void EditorBenchmark::indentSelection()
+{
+    Editor editor;
+    editor.setPlainText(corpusText());
+
+    QBENCHMARK
+    {
+        editor.selectAll();
+        editor.indentSelection(editor.textCursor().selection());
+        editor.undo();
+    }
+}
+
+
+void EditorBenchmark::handleEnterKeyPress_data()
+{
+    addCorpusRows({Corpus::CppSource, Corpus::JavaSource, Corpus::PythonSource});
+}
+
+
+// Enter после открывающего разделителя блока в середине документа, затем отмена.
+void EditorBenchmark::handleEnterKeyPress()
+{
+    QFETCH(int, kind);
+
+    Editor editor;
+    editor.setPlainText(corpusText());
+    editor.setProgrammingLanguage(languageOf(Corpus::Kind(kind)));
+
+    QChar blockStart = Corpus::Kind(kind) == Corpus::PythonSource ? ':' : '{';
+    QString text = editor.toPlainText();
+    int position = text.indexOf(QString(blockStart) + '\n', text.length() / 2);
+    if (position < 0)
+    {
+        position = text.indexOf(QString(blockStart) + '\n');
+    }
+    QVERIFY(position >= 0);
+
+    QTextCursor afterDelimiter(editor.document());
+    afterDelimiter.setPosition(position + 1);
+
+    QBENCHMARK
+    {
+        editor.setTextCursor(afterDelimiter);
+
+        // Одна пакетная правка, чтобы одна отмена убрала все вставки
+        QTextCursor editBlock(editor.document());
+        editBlock.beginEditBlock();
+        editor.handleEnterKeyPress();
+        editBlock.endEditBlock();
+
+        editor.undo();
+    }
+}
+
+
+void EditorBenchmark::switchTabs_data()
+{
+    addCorpusRows({Corpus::CppSource});
+}
+
+
+// Переключение между TABS_TO_SWITCH вкладками с документами одного размера в главном окне.
+void EditorBenchmark::switchTabs()
+{
+    MainWindow window;
+    TabbedEditor *tabs = window.findChild<TabbedEditor*>();
+    QVERIFY(tabs != nullptr);
+
+    QString text = corpusText();
+    tabs->currentTab()->setPlainText(text);
+
+    for (int i = 1; i < TABS_TO_SWITCH; i++)
+    {
+        Editor *tab = new Editor();
+        tabs->add(tab);
+        tab->setPlainText(text);
+    }
+
+    QBENCHMARK
+    {
+        tabs->setCurrentIndex((tabs->currentIndex() + 1) % tabs->count());
+    }
+}
+
+
+void EditorBenchmark::startup_data()
+{
+    QTest::addColumn<bool>("eager");
+
+    QTest::addRow("deferred") << false;
+    QTest::addRow("eager") << true;
+}
+
+
+/* Создание и первый показ главного окна. Строка "eager" дополнительно строит диалоги
+   и окно памяти до показа, как это делалось до отложенного запуска, для сравнения.
+ */
+void EditorBenchmark::startup()
+{
+    QFETCH(bool, eager);
+
+    QBENCHMARK
+    {
+        MainWindow window;
+
+        if (eager)
+        {
+            window.findDialogInstance();
+            window.gotoDialogInstance();
+            window.memoryViewInstance();
+        }
+
+        window.show();
+        QVERIFY(QTest::qWaitForWindowExposed(&window));
+    }
+}
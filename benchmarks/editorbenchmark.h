@@ -0,0 +1,49 @@
+#ifndef EDITORBENCHMARK_H
+#define EDITORBENCHMARK_H
+#include "corpus.h"
+#include <QObject>
+#include <QTemporaryDir>
+
+
+/* Бенчмарки основных операций редактора на сгенерированных корпусах. Каждый бенчмарк
+   параметризован видом и размером корпуса (строка данных "вид/размер"), поэтому результаты
+   в CSV или XML можно сравнивать между выпусками построчно.
+ */
+class EditorBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void openFile_data();
+    void openFile();
+    void saveFile_data();
+    void saveFile();
+    void updateWordCount_data();
+    void updateWordCount();
+    void highlight_data();
+    void highlight();
+    void find_data();
+    void find();
+    void replaceAll_data();
+    void replaceAll();
+    void indentSelection_data();
+    void indentSelection();
+    void handleEnterKeyPress_data();
+    void handleEnterKeyPress();
+    void switchTabs_data();
+    void switchTabs();
+    void startup_data();
+    void startup();
+
+private:
+    void addCorpusRows(const QVector<Corpus::Kind> &kinds);
+    void addAllCorpusRows();
+    QString corpusText();
+    QString corpusFile();
+
+    QTemporaryDir directory;
+};
+
+#endif // EDITORBENCHMARK_H
@@ -0,0 +1,24 @@
+#include "editorbenchmark.h"
+#include <QApplication>
+#include <QtTest>
+
+
+/* По умолчанию результаты печатаются в CSV (одна строка на бенчмарк и корпус), чтобы их
+   можно было сохранять и сравнивать между выпусками. Явно заданный -o (например,
+   -o results.xml,xml) отключает формат по умолчанию.
+ */
+int main(int argc, char *argv[])
+{
+    QApplication app(argc, argv);
+    app.setOrganizationName("Kerimov David, Slobodan Lelikov");
+    app.setApplicationName("TextrBenchmarks");
+
+    QStringList arguments = app.arguments();
+    if (!arguments.contains("-o"))
+    {
+        arguments << "-o" << "-,csv";
+    }
+
+    EditorBenchmark benchmark;
+    return QTest::qExec(&benchmark, arguments);
+}
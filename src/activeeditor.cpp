@@ -0,0 +1,83 @@
+#include "activeeditor.h"
+
+
+ActiveEditor::ActiveEditor(QObject *parent) : QObject(parent)
+{
+}
+
+
+// Делает tab активным редактором; сигналы остальных редакторов больше не пересылаются.
+void ActiveEditor::setEditor(Editor *tab)
+{
+    if (active == tab)
+    {
+        return;
+    }
+
+    active = tab;
+    emit editorChanged(tab);
+}
+
+
+/* Пересылает сигнал вкладки tab в сигнал посредника relay, только пока tab активна.
+   Соединение проверяется при компиляции и удаляется вместе с вкладкой.
+ */
+template <typename Sender, typename... Args>
+void ActiveEditor::forward(Editor *tab, void (Sender::*signal)(Args...), void (ActiveEditor::*relay)(Args...))
+{
+    connect(tab, signal, this, [this, tab, relay](Args... args) {
+        if (tab == active)
+        {
+            emit (this->*relay)(args...);
+        }
+    });
+}
+
+
+// Подключает новую вкладку. Вызывается один раз на вкладку из TabbedEditor::add.
+void ActiveEditor::attach(Editor *tab)
+{
+    forward(tab, &Editor::findResultReady, &ActiveEditor::findResultReady);
+    forward(tab, &Editor::gotoResultReady, &ActiveEditor::gotoResultReady);
+    forward(tab, &Editor::metricsChanged, &ActiveEditor::metricsChanged);
+    forward(tab, &Editor::titleStateChanged, &ActiveEditor::titleStateChanged);
+    forward(tab, &Editor::undoAvailable, &ActiveEditor::undoAvailable);
+    forward(tab, &Editor::redoAvailable, &ActiveEditor::redoAvailable);
+    forward(tab, &Editor::copyAvailable, &ActiveEditor::copyAvailable);
+}
+
+
+void ActiveEditor::find(QString query, bool caseSensitive, bool wholeWords)
+{
+    if (active)
+    {
+        active->find(query, caseSensitive, wholeWords);
+    }
+}
+
+
+void ActiveEditor::replace(QString what, QString with, bool caseSensitive, bool wholeWords)
+{
+    if (active)
+    {
+        active->replace(what, with, caseSensitive, wholeWords);
+    }
+}
+
+
+void ActiveEditor::replaceAll(QString what, QString with, bool caseSensitive, bool wholeWords)
+{
+    if (active)
+    {
+        active->replaceAll(what, with, caseSensitive, wholeWords);
+    }
+}
+
+
+void ActiveEditor::goTo(int line)
+{
+    if (active)
+    {
+        active->goTo(line);
+    }
+}
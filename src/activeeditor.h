@@ -0,0 +1,48 @@
+#ifndef ACTIVEEDITOR_H
+#define ACTIVEEDITOR_H
+#include "editor.h"
+#include <QObject>
+#include <QPointer>
+
+
+/* Посредник между окном и текущей вкладкой. Каждая вкладка подключается к нему один раз
+   при добавлении (attach), а диалоги и строка состояния - один раз к нему самому.
+   Сигналы фоновых вкладок отбрасываются, поэтому при переключении вкладки меняется
+   только указатель на активный редактор, а соединения не пересоздаются. В разделенной
+   вкладке активен вид, в котором фокус.
+ */
+class ActiveEditor : public QObject
+{
+    Q_OBJECT
+
+public:
+    ActiveEditor(QObject *parent = nullptr);
+
+    void attach(Editor *tab);
+    void setEditor(Editor *tab);
+    inline Editor *editor() const { return active; }
+
+signals:
+    void editorChanged(Editor *tab);
+    void findResultReady(QString message);
+    void gotoResultReady(QString message);
+    void metricsChanged(DocumentMetrics metrics);
+    void titleStateChanged();
+    void undoAvailable(bool available);
+    void redoAvailable(bool available);
+    void copyAvailable(bool available);
+
+public slots:
+    void find(QString query, bool caseSensitive, bool wholeWords);
+    void replace(QString what, QString with, bool caseSensitive, bool wholeWords);
+    void replaceAll(QString what, QString with, bool caseSensitive, bool wholeWords);
+    void goTo(int line);
+
+private:
+    template <typename Sender, typename... Args>
+    void forward(Editor *tab, void (Sender::*signal)(Args...), void (ActiveEditor::*relay)(Args...));
+
+    QPointer<Editor> active;
+};
+
+#endif // ACTIVEEDITOR_H
@@ -0,0 +1,341 @@
+#include "batch.h"
+#include "editor.h"
+#include "utilityfunctions.h"
+#include <QCommandLineParser>
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QTextStream>
+#include <QTextDocument>
+#include <QTextBlock>
+#include <QTextLayout>
+#include <QPlainTextDocumentLayout>
+#include <QScopedPointer>
+#include <QThreadPool>
+#include <QtConcurrent/QtConcurrentMap>
+#include <algorithm>
+#include <cstring>
+
+
+namespace
+{
+    // Один файл пакетной команды; заполняется рабочим потоком
+    struct Job
+    {
+        QString path;
+        QString output;
+        QString error;
+        int matches = 0;
+        qint64 words = 0;
+        qint64 characters = 0;
+        qint64 lines = 0;
+    };
+
+    struct Options
+    {
+        QString command;
+        QString query;
+        QString replacement;
+        QTextDocument::FindFlags searchOptions;
+        QString outputDirectory;
+    };
+
+
+    // Читает файл так же, как MainWindow при открытии.
+    bool readFile(const QString &path, QString &contents, QString &error)
+    {
+        QFile file(path);
+        if (!file.open(QIODevice::ReadOnly | QFile::Text))
+        {
+            error = "Cannot open file: " + file.errorString();
+            return false;
+        }
+
+        QTextStream in(&file);
+        contents = in.readAll();
+        return true;
+    }
+
+
+    // Записывает файл так же, как MainWindow при сохранении.
+    bool writeFile(const QString &path, const QString &contents, QString &error)
+    {
+        QFile file(path);
+        if (!file.open(QIODevice::WriteOnly | QFile::Text))
+        {
+            error = "Cannot save file: " + file.errorString();
+            return false;
+        }
+
+        QTextStream out(&file);
+        out << contents;
+        return true;
+    }
+
+
+    // Документ без виджета; раскладка нужна подсветке, чтобы хранить форматы блоков.
+    void setUpDocument(QTextDocument &document, const QString &contents)
+    {
+        document.setDocumentLayout(new QPlainTextDocumentLayout(&document));
+        document.setPlainText(contents);
+    }
+
+
+    // Слова, символы и строки, как в DocumentMetrics редактора.
+    void count(Job &job, const QString &contents)
+    {
+        job.words = Utility::countWords(contents);
+        job.characters = contents.length();
+        job.lines = contents.count('\n') + 1;
+        job.output = QString("%1\t%2\t%3\t%4\n").arg(job.words).arg(job.characters).arg(job.lines).arg(job.path);
+    }
+
+
+    // Печатает каждое совпадение в виде путь:строка:колонка:текст строки.
+    void find(Job &job, const QString &contents, const Options &options)
+    {
+        QTextDocument document;
+        setUpDocument(document, contents);
+
+        QTextCursor match = document.find(options.query, 0, options.searchOptions);
+        while (!match.isNull())
+        {
+            QTextBlock block = match.block();
+            int column = match.selectionStart() - block.position();
+            job.output += QString("%1:%2:%3:%4\n").arg(job.path).arg(block.blockNumber() + 1).arg(column + 1).arg(block.text());
+            job.matches++;
+            match = document.find(options.query, match, options.searchOptions);
+        }
+    }
+
+
+    // Заменяет все совпадения тем же кодом, что и "Заменить всё" в редакторе, и перезаписывает файл.
+    void replaceAll(Job &job, const QString &contents, const Options &options)
+    {
+        QTextDocument document;
+        setUpDocument(document, contents);
+        document.setUndoRedoEnabled(false);
+
+        job.matches = Editor::replaceAllIn(&document, options.query, options.replacement, options.searchOptions);
+
+        if (job.matches > 0 && !writeFile(job.path, document.toPlainText(), job.error))
+        {
+            return;
+        }
+
+        job.output = QString("%1: %2 replacements\n").arg(job.path).arg(job.matches);
+    }
+
+
+    QString styleOf(const QTextCharFormat &format)
+    {
+        QString style;
+
+        if (format.foreground().style() != Qt::NoBrush)
+        {
+            style += "color:" + format.foreground().color().name() + ";";
+        }
+        if (format.fontWeight() > QFont::Normal)
+        {
+            style += "font-weight:bold;";
+        }
+        if (format.fontItalic())
+        {
+            style += "font-style:italic;";
+        }
+
+        return style;
+    }
+
+
+    /* Подсвечивает документ тем же Highlighter, что и редактор, и переносит форматы,
+       которые подсветка хранит в раскладке блоков, в HTML.
+     */
+    void exportHtml(Job &job, const QString &contents, const Options &options)
+    {
+        QTextDocument document;
+        setUpDocument(document, contents);
+
+        QFileInfo fileInfo(job.path);
+        QScopedPointer<Highlighter> highlighter(Editor::generateHighlighterFor(fromFileName(fileInfo.fileName()), &document));
+        if (highlighter)
+        {
+            highlighter->rehighlight();
+        }
+
+        QString html;
+        html.reserve(contents.length() * 2);
+        html += "<!DOCTYPE html>\n<html>\n<head><meta charset=\"utf-8\"><title>" + fileInfo.fileName().toHtmlEscaped() +
+                "</title></head>\n<body>\n<pre>";
+
+        for (QTextBlock block = document.begin(); block.isValid(); block = block.next())
+        {
+            const QString text = block.text();
+            QVector<QTextLayout::FormatRange> ranges = block.layout()->formats();
+            std::sort(ranges.begin(), ranges.end(), [](const QTextLayout::FormatRange &a, const QTextLayout::FormatRange &b) {
+                return a.start < b.start;
+            });
+
+            int position = 0;
+            for (const QTextLayout::FormatRange &range : ranges)
+            {
+                if (range.start < position || range.length <= 0)
+                {
+                    continue;
+                }
+
+                html += text.mid(position, range.start - position).toHtmlEscaped();
+                html += "<span style=\"" + styleOf(range.format) + "\">" + text.mid(range.start, range.length).toHtmlEscaped() + "</span>";
+                position = range.start + range.length;
+            }
+
+            html += text.mid(position).toHtmlEscaped();
+            html += '\n';
+        }
+
+        html += "</pre>\n</body>\n</html>\n";
+
+        QString directory = options.outputDirectory.isEmpty() ? fileInfo.absolutePath() : options.outputDirectory;
+        QString htmlPath = QDir(directory).filePath(fileInfo.fileName() + ".html");
+
+        if (writeFile(htmlPath, html, job.error))
+        {
+            job.output = htmlPath + "\n";
+        }
+    }
+
+
+    void process(Job &job, const Options &options)
+    {
+        QString contents;
+        if (!readFile(job.path, contents, job.error))
+        {
+            return;
+        }
+
+        if (options.command == "count")
+        {
+            count(job, contents);
+        }
+        else if (options.command == "find")
+        {
+            find(job, contents, options);
+        }
+        else if (options.command == "replace")
+        {
+            replaceAll(job, contents, options);
+        }
+        else
+        {
+            exportHtml(job, contents, options);
+        }
+    }
+}
+
+
+// Возвращает true, если приложение запущено с --batch; проверяется до создания QApplication.
+bool Batch::isRequested(int argc, char *argv[])
+{
+    for (int i = 1; i < argc; i++)
+    {
+        if (std::strcmp(argv[i], "--batch") == 0)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+/* Разбирает аргументы пакетного режима, обрабатывает файлы параллельно и печатает результаты.
+   Код возврата: 0 - успех, 1 - ошибка хотя бы одного файла (или ни одного совпадения для find), 2 - неверные аргументы.
+ */
+int Batch::run(const QStringList &arguments)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Textr batch mode.\n"
+                                     "  count FILES...            words, chars and lines of each file\n"
+                                     "  find QUERY FILES...       print path:line:column:text of every match\n"
+                                     "  replace WHAT WITH FILES... replace all matches in place\n"
+                                     "  html FILES...             export syntax-highlighted HTML");
+    parser.addHelpOption();
+    parser.addOption(QCommandLineOption("batch", "Run without a window."));
+    QCommandLineOption caseSensitiveOption(QStringList() << "c" << "case-sensitive", "Case-sensitive search.");
+    QCommandLineOption wholeWordsOption(QStringList() << "w" << "whole-words", "Match whole words only.");
+    QCommandLineOption outputOption(QStringList() << "o" << "output", "Directory for exported HTML files.", "directory");
+    QCommandLineOption jobsOption(QStringList() << "j" << "jobs", "Number of files processed in parallel.", "count");
+    parser.addOptions({caseSensitiveOption, wholeWordsOption, outputOption, jobsOption});
+    parser.addPositionalArgument("command", "count, find, replace or html.");
+    parser.process(arguments);
+
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+    QStringList positional = parser.positionalArguments();
+
+    Options options;
+    options.command = positional.value(0);
+    options.searchOptions = Editor::getSearchOptionsFromFlags(parser.isSet(caseSensitiveOption), parser.isSet(wholeWordsOption));
+    options.outputDirectory = parser.value(outputOption);
+
+    int patternArguments = options.command == "find" ? 1 : options.command == "replace" ? 2 : 0;
+    bool knownCommand = QStringList({"count", "find", "replace", "html"}).contains(options.command);
+
+    if (!knownCommand || positional.size() < 2 + patternArguments)
+    {
+        err << parser.helpText();
+        return 2;
+    }
+
+    options.query = positional.value(1);
+    options.replacement = positional.value(2);
+
+    if (parser.isSet(jobsOption) && parser.value(jobsOption).toInt() > 0)
+    {
+        QThreadPool::globalInstance()->setMaxThreadCount(parser.value(jobsOption).toInt());
+    }
+
+    QVector<Job> jobs;
+    for (const QString &path : positional.mid(1 + patternArguments))
+    {
+        Job job;
+        job.path = path;
+        jobs.append(job);
+    }
+
+    QtConcurrent::blockingMap(jobs, [&options](Job &job) {
+        process(job, options);
+    });
+
+    int failures = 0;
+    int matches = 0;
+    Job total;
+
+    for (const Job &job : jobs)
+    {
+        out << job.output;
+
+        if (!job.error.isEmpty())
+        {
+            err << job.path << ": " << job.error << "\n";
+            failures++;
+        }
+
+        matches += job.matches;
+        total.words += job.words;
+        total.characters += job.characters;
+        total.lines += job.lines;
+    }
+
+    if (options.command == "count" && jobs.size() > 1)
+    {
+        out << QString("%1\t%2\t%3\ttotal\n").arg(total.words).arg(total.characters).arg(total.lines);
+    }
+
+    if (failures > 0 || (options.command == "find" && matches == 0))
+    {
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,17 @@
+#ifndef BATCH_H
+#define BATCH_H
+#include <QStringList>
+
+
+/* Пакетный режим без окна: textr --batch <команда> [параметры] файлы...
+   Команды используют те же пути кода, что и редактор (подсчет слов, поиск и замена
+   через QTextDocument, подсветка через Highlighter), а файлы обрабатываются параллельно
+   в пуле потоков. Результаты печатаются в порядке файлов в командной строке.
+ */
+namespace Batch
+{
+    bool isRequested(int argc, char *argv[]);
+    int run(const QStringList &arguments);
+}
+
+#endif // BATCH_H
@@ -0,0 +1,108 @@
+#include "clipboardmimedata.h"
+#include <QTextBlock>
+
+
+/* Запоминает выделенный диапазон документа. Курсор range автоматически сдвигается
+   при правках до выделения, поэтому диапазон остается корректным, пока правки его не затрагивают.
+ */
+ClipboardMimeData::ClipboardMimeData(QTextDocument *document, int selectionStart, int selectionEnd)
+    : document(document), range(document)
+{
+    range.setPosition(selectionStart);
+    range.setPosition(selectionEnd, QTextCursor::KeepAnchor);
+}
+
+
+// Предлагаем только простой текст: HTML для больших выделений слишком дорог.
+QStringList ClipboardMimeData::formats() const
+{
+    return QStringList() << "text/plain";
+}
+
+
+bool ClipboardMimeData::hasFormat(const QString &mimeType) const
+{
+    return mimeType == "text/plain";
+}
+
+
+/* Возвращает true, если правка в диапазоне [from, to] затронет запомненный текст.
+   После detach() снимок уже не зависит от документа.
+ */
+bool ClipboardMimeData::intersects(int from, int to) const
+{
+    if (detached)
+    {
+        return false;
+    }
+
+    return from <= range.selectionEnd() && to >= range.selectionStart();
+}
+
+
+/* Материализует текст диапазона прямо сейчас. Вызывается редактором перед правкой,
+   затрагивающей диапазон, или перед уничтожением документа.
+ */
+void ClipboardMimeData::detach()
+{
+    if (detached)
+    {
+        return;
+    }
+
+    snapshot = readRange();
+    detached = true;
+    range = QTextCursor();
+}
+
+
+/* Вызывается, когда другое приложение (или сам редактор при вставке) запрашивает данные.
+   Только здесь текст впервые собирается из документа.
+ */
+QVariant ClipboardMimeData::retrieveData(const QString &mimeType, QVariant::Type preferredType) const
+{
+    Q_UNUSED(preferredType)
+
+    if (mimeType != "text/plain")
+    {
+        return QVariant();
+    }
+
+    return detached ? snapshot : readRange();
+}
+
+
+/* Собирает текст диапазона поблочно в заранее зарезервированную строку.
+   В отличие от QTextCursor::selectedText разделители абзацев сразу заменяются на '\n'.
+ */
+QString ClipboardMimeData::readRange() const
+{
+    if (document.isNull() || range.isNull())
+    {
+        return QString();
+    }
+
+    int start = range.selectionStart();
+    int end = range.selectionEnd();
+
+    QString text;
+    text.reserve(end - start);
+
+    QTextBlock block = document->findBlock(start);
+    while (block.isValid() && block.position() <= end)
+    {
+        int blockStart = block.position();
+        int from = qMax(start, blockStart) - blockStart;
+        int to = qMin(end, blockStart + block.length() - 1) - blockStart;
+
+        if (blockStart > start)
+        {
+            text += '\n';
+        }
+
+        text += block.text().mid(from, to - from);
+        block = block.next();
+    }
+
+    return text;
+}
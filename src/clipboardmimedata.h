@@ -0,0 +1,39 @@
+#ifndef CLIPBOARDMIMEDATA_H
+#define CLIPBOARDMIMEDATA_H
+#include <QMimeData>
+#include <QPointer>
+#include <QTextDocument>
+#include <QTextCursor>
+
+
+/* Данные буфера обмена для больших выделений. Вместо того чтобы копировать выделенный
+   текст (и генерировать HTML через QTextDocumentFragment) в момент копирования, запоминает
+   диапазон в документе и отдает только text/plain, когда его запрашивает другое приложение.
+ */
+class ClipboardMimeData : public QMimeData
+{
+    Q_OBJECT
+
+public:
+    ClipboardMimeData(QTextDocument *document, int selectionStart, int selectionEnd);
+
+    QStringList formats() const override;
+    bool hasFormat(const QString &mimeType) const override;
+
+    bool intersects(int from, int to) const;
+    void detach();
+    inline bool isDetached() const { return detached; }
+
+protected:
+    QVariant retrieveData(const QString &mimeType, QVariant::Type preferredType) const override;
+
+private:
+    QString readRange() const;
+
+    QPointer<QTextDocument> document;
+    QTextCursor range;
+    QString snapshot;
+    bool detached = false;
+};
+
+#endif // CLIPBOARDMIMEDATA_H
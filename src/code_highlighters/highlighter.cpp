@@ -1,4 +1,6 @@
 #include "highlighter.h"
+#include "../latencymonitor.h"
+#include "../tracer.h"
 #include <QtDebug>
 
 
@@ -45,6 +47,8 @@ void Highlighter::addRule(QRegularExpression pattern, QTextCharFormat format)
  */
 void Highlighter::highlightBlock(const QString &text)
 {
+    LatencyProbe probe(LatencyMonitor::HighlightBlock);
+    TraceScope trace("Highlighter::highlightBlock", "highlight");
     // Try to find matches for all rules (except comments) and apply their formatting
     foreach(const HighlightingRule &rule, rules)
     {
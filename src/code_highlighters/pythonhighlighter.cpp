@@ -1,4 +1,6 @@
 #include "pythonhighlighter.h"
+#include "../latencymonitor.h"
+#include "../tracer.h"
 
 
 PythonHighlighter::PythonHighlighter(QTextDocument *parent) : Highlighter(parent)
@@ -30,6 +32,8 @@ PythonHighlighter::PythonHighlighter(QTextDocument *parent) : Highlighter(parent
 
 void PythonHighlighter::highlightBlock(const QString &text)
 {
+    LatencyProbe probe(LatencyMonitor::HighlightBlock);
+    TraceScope trace("PythonHighlighter::highlightBlock", "highlight");
     // Try to find matches for all rules (except comments) and apply their formatting
     foreach(const HighlightingRule &rule, rules)
     {
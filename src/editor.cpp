@@ -11,7 +11,19 @@
 #include <QTextDocumentFragment>
 #include <QPalette>
 #include <QStack>
+#include <QFile>
 #include <QFileInfo>
+#include <QAbstractItemView>
+#include <QScrollBar>
+#include <QSet>
+#include <QMouseEvent>
+#include <QDropEvent>
+#include <QInputMethodEvent>
+#include <QContextMenuEvent>
+#include <QAction>
+#include <QTextCodec>
+#include <QTextStream>
+#include <QtConcurrent/QtConcurrentRun>
 #include <QtDebug>
 
 
@@ -20,12 +32,44 @@ const QColor Editor::LINE_COLOR = QColor(Qt::lightGray).lighter(125);
 
 // Инициализация editor
 Editor::Editor(QWidget *parent) : QPlainTextEdit (parent) {
+    initialize();
+}
+
+
+/* Создает дополнительный вид документа primary для разделенной вкладки. Документ, подсветка
+   и раскладка общие; у вида свои курсор, прокрутка, поле номеров строк и миникарта.
+   Индекс идентификаторов, учет памяти и свернутые регионы остаются у основного редактора.
+ */
+Editor::Editor(Editor *primary, QWidget *parent) : QPlainTextEdit (parent), primary(primary) {
+    setDocument(primary->document());
+    primary->views.append(this);
+    initialize();
+    metrics.wordCount = primary->metrics.wordCount;
+    metrics.charCount = primary->metrics.charCount;
+
+    // Количество слов и символов считает только основной редактор; вид берет их из его снимка
+    connect(primary, &Editor::metricsChanged, this, [this](DocumentMetrics primaryMetrics) {
+        metrics.wordCount = primaryMetrics.wordCount;
+        metrics.charCount = primaryMetrics.charCount;
+        emitMetrics();
+    });
+
+    primary->setLineWrapMode(primary->lineWrapMode);
+}
+
+
+void Editor::initialize() {
     readSettings();
-    document()->setModified(false);
+
+    if (!primary)
+    {
+        document()->setModified(false);
+    }
 
     setProgrammingLanguage(Language::None);
     metrics = DocumentMetrics();
     lineNumberArea = new LineNumberArea(this);
+    minimap = new Minimap(this);
     setFont(QFont("Courier", DEFAULT_FONT_SIZE), QFont::Monospace, true, NUM_CHARS_FOR_TAB);
 
     connect(this, SIGNAL(blockCountChanged(int)), this, SLOT(updateLineNumberAreaWidth()));
@@ -34,8 +78,37 @@ Editor::Editor(QWidget *parent) : QPlainTextEdit (parent) {
     connect(this, SIGNAL(textChanged()), this, SLOT(on_textChanged()));
     connect(this, SIGNAL(undoAvailable(bool)), this, SLOT(setUndoAvailable(bool)));
     connect(this, SIGNAL(redoAvailable(bool)), this, SLOT(setRedoAvailable(bool)));
+    connect(document(), SIGNAL(modificationChanged(bool)), this, SIGNAL(titleStateChanged()));
+
+    // Индекс идентификаторов обновляется только по измененным блокам. Он хранит данные в блоках
+    // документа, поэтому у дополнительного вида своего индекса нет
+    if (!primary)
+    {
+        identifierIndex.attach(document());
+        connect(document(), SIGNAL(contentsChange(int, int, int)), this, SLOT(on_contentsChange(int, int, int)));
+
+        journal = new RecoveryJournal(this);
+        journalCompactionTimer = new QTimer(this);
+        journalCompactionTimer->setSingleShot(true);
+        journalCompactionTimer->setInterval(JOURNAL_COMPACT_IDLE_MS);
+        connect(journalCompactionTimer, SIGNAL(timeout()), this, SLOT(compactJournal()));
+        connect(document(), SIGNAL(modificationChanged(bool)), this, SLOT(on_modificationChanged(bool)));
+    }
+
+    completionModel = new QStringListModel(this);
+    completer = new QCompleter(completionModel, this);
+    completer->setWidget(this);
+    completer->setCompletionMode(QCompleter::UnfilteredPopupCompletion);
+    connect(completer, SIGNAL(activated(QString)), this, SLOT(insertCompletion(QString)));
+
+    // Правки и движения курсора за кадр сводятся в один снимок метрик для строки состояния
+    metricsTimer = new QTimer(this);
+    metricsTimer->setSingleShot(true);
+    metricsTimer->setInterval(STATUS_UPDATE_INTERVAL_MS);
+    connect(metricsTimer, SIGNAL(timeout()), this, SLOT(emitMetrics()));
 
     installEventFilter(this);
+    refreshGutterMetrics();
     updateLineNumberAreaWidth();
     on_cursorPositionChanged();
 }
@@ -43,15 +116,38 @@ Editor::Editor(QWidget *parent) : QPlainTextEdit (parent) {
 
 // чтобы не было утечек
 Editor::~Editor() {
+    // Виды работают с документом этого редактора, поэтому удаляются раньше него
+    for (Editor *view : QVector<Editor*>(views))
+    {
+        delete view;
+    }
+
+    if (primary)
+    {
+        primary->views.removeOne(this);
+        primary->setLineWrapMode(primary->lineWrapMode);
+    }
+    else
+    {
+        FileWatcher::instance()->unwatch(this);
+    }
+
+    // Буфер обмена может пережить документ, поэтому забираем из него текст заранее
+    preserveClipboardSnapshot();
     delete lineNumberArea;
+    delete hibernated;
 }
 
 
 //reset в исходное состояние
 void Editor::reset() {
+    preserveClipboardSnapshot();
     currentFilePath.clear();
+    disk = DiskState();
+    FileWatcher::instance()->unwatch(this);
     document()->setModified(false);
     setPlainText(QString());
+    emit titleStateChanged();
 }
 
 
@@ -60,6 +156,12 @@ void Editor::reset() {
 void Editor::setCurrentFilePath(QString newPath) {
     currentFilePath = newPath;
     fileIsUntitled = false;
+
+    if (!primary)
+    {
+        FileWatcher::instance()->watch(this, newPath);
+    }
+    emit titleStateChanged();
 }
 
 
@@ -82,6 +184,7 @@ QString Editor::getFileNameFromPath() {
    tabStopWidth - желаемая ширина табуляции в пересчете на эквивалентное количество пробелов
  */
 void Editor::setFont(QFont newFont, QFont::StyleHint styleHint, bool fixedPitch, int tabStopWidth) {
+    fontPending = false;
     font = newFont;
     font.setStyleHint(styleHint);
     font.setFixedPitch(fixedPitch);
@@ -99,24 +202,44 @@ void Editor::setProgrammingLanguage(Language language) {
         return;
     }
 
+    // Прежний подсветчик снимает свои форматы с документа при удалении
+    // Снятие форматов выдает contentsChange, который не является правкой текста
     this->programmingLanguage = language;
-    this->syntaxHighlighter = generateHighlighterFor(language);
+    releasingCaches = true;
+    delete this->syntaxHighlighter;
+    releasingCaches = false;
+    this->syntaxHighlighter = nullptr;
+    formatsReleased = false;
+
+    // Выгруженной вкладке и вкладке из сессии подсветчик не нужен до загрузки текста:
+    // его правила компилируются при создании, поэтому он создается в rehydrate
+    if (isHibernated())
+    {
+        return;
+    }
+
+    this->syntaxHighlighter = generateHighlighterFor(language, document());
+
+    // Новый подсветчик раскрашивает документ отложенно, поэтому миникарта сбрасывается после него
+    if (minimap)
+    {
+        QTimer::singleShot(0, minimap, SLOT(invalidateAll()));
+    }
 }
 
 
 /* Возвращает highlighter для соответ языка
    language - язык для которого должна быть подсветка
+   document - документ, к которому подключается highlighter (он же его владелец)
  */
-Highlighter *Editor::generateHighlighterFor(Language language)
+Highlighter *Editor::generateHighlighterFor(Language language, QTextDocument *document)
 {
-    QTextDocument *doc = document();
-
     switch (language)
     {
-        case (Language::C): return new CHighlighter(doc);
-        case (Language::CPP): return new CPPHighlighter(doc);
-        case (Language::Java): return new JavaHighlighter(doc);
-        case (Language::Python): return new PythonHighlighter(doc);
+        case (Language::C): return new CHighlighter(document);
+        case (Language::CPP): return new CPPHighlighter(document);
+        case (Language::Java): return new JavaHighlighter(document);
+        case (Language::Python): return new PythonHighlighter(document);
         default: return nullptr;
     }
 }
@@ -152,6 +275,7 @@ QTextDocument::FindFlags Editor::getSearchOptionsFromFlags(bool caseSensitive, b
  */
 bool Editor::find(QString query, bool caseSensitive, bool wholeWords)
 {
+    TraceScope trace("Editor::find", "search");
     // Сохраняем позицию курсора до начала поиска, чтобы вернуть её, если совпадений не будет найдено
     int cursorPositionBeforeCurrentSearch = textCursor().position();
 
@@ -223,6 +347,8 @@ bool Editor::find(QString query, bool caseSensitive, bool wholeWords)
  */
 void Editor::replace(QString what, QString with, bool caseSensitive, bool wholeWords)
 {
+    TraceScope trace("Editor::replace", "search");
+    preserveClipboardSnapshot();
     bool found = find(what, caseSensitive, wholeWords);
 
     if (found)
@@ -242,28 +368,16 @@ void Editor::replace(QString what, QString with, bool caseSensitive, bool wholeW
    wholeWords - флаг, обозначающий, искать ли только целые слова или частичные совпадения
  */
 void Editor::replaceAll(QString what, QString with, bool caseSensitive, bool wholeWords) {
+    TraceScope trace("Editor::replaceAll", "search");
+    preserveClipboardSnapshot();
+
     // Оптимизация: не обновляем экран до завершения всех замен
     disconnect(this, SIGNAL(cursorPositionChanged()), this, SLOT(on_cursorPositionChanged()));
     disconnect(this, SIGNAL(textChanged()), this, SLOT(on_textChanged()));
 
-    // Начинаем поиск с самого начала документа
-    moveCursorTo(0);
-
-    // Выполняем начальный поиск; не полагаемся на наш пользовательский find
+    // Не полагаемся на наш пользовательский find: замены идут по документу от начала до конца
     QTextDocument::FindFlags searchOptions = getSearchOptionsFromFlags(caseSensitive, wholeWords);
-    bool found = QPlainTextEdit::find(what, searchOptions);
-    int replacements = 0;
-
-    // Продолжаем замену, пока остаются совпадения
-    QTextCursor cursor(document());
-    cursor.beginEditBlock();
-    while (found) {
-        QTextCursor currentPosition = textCursor();
-        currentPosition.insertText(with);
-        replacements++;
-        found = QPlainTextEdit::find(what, searchOptions);
-    }
-    cursor.endEditBlock();
+    int replacements = replaceAllIn(document(), what, with, searchOptions);
 
     // Сообщение по завершении операции
     if (replacements == 0) {
@@ -280,6 +394,30 @@ void Editor::replaceAll(QString what, QString with, bool caseSensitive, bool who
 }
 
 
+/* Заменяет все совпадения what в документе на with одной пакетной правкой (один шаг отмены).
+   Возвращает количество замен. Не требует виджета, поэтому используется и пакетным режимом.
+ */
+int Editor::replaceAllIn(QTextDocument *document, const QString &what, const QString &with,
+                         QTextDocument::FindFlags searchOptions)
+{
+    int replacements = 0;
+
+    QTextCursor cursor(document);
+    cursor.beginEditBlock();
+
+    QTextCursor match = document->find(what, 0, searchOptions);
+    while (!match.isNull())
+    {
+        match.insertText(with);
+        replacements++;
+        match = document->find(what, match, searchOptions);
+    }
+
+    cursor.endEditBlock();
+    return replacements;
+}
+
+
 void Editor::goTo(int line)
 {
     if (line > blockCount() || line < 1) {
@@ -292,6 +430,191 @@ void Editor::goTo(int line)
 }
 
 
+/* Вырезает выделенный текст. Выделение сразу удаляется из документа, поэтому
+   данные буфера обмена здесь формируются немедленно, а не лениво.
+ */
+void Editor::cut()
+{
+    eagerClipboard = true;
+    QPlainTextEdit::cut();
+    eagerClipboard = false;
+}
+
+
+// Отменяет последнюю правку, предварительно сохранив ленивые данные буфера обмена.
+void Editor::undo()
+{
+    preserveClipboardSnapshot();
+    QPlainTextEdit::undo();
+}
+
+
+// Повторяет отмененную правку, предварительно сохранив ленивые данные буфера обмена.
+void Editor::redo()
+{
+    preserveClipboardSnapshot();
+    QPlainTextEdit::redo();
+}
+
+
+/* Вызывается при копировании, вырезании и перетаскивании. Для больших выделений возвращает
+   ClipboardMimeData, который хранит только диапазон и отдает текст по запросу, без HTML.
+   Небольшие выделения обрабатываются стандартной реализацией QPlainTextEdit.
+ */
+QMimeData *Editor::createMimeDataFromSelection() const
+{
+    QTextCursor cursor = textCursor();
+    int selectionLength = cursor.selectionEnd() - cursor.selectionStart();
+
+    if (selectionLength < LAZY_CLIPBOARD_THRESHOLD)
+    {
+        return QPlainTextEdit::createMimeDataFromSelection();
+    }
+
+    ClipboardMimeData *data = new ClipboardMimeData(document(), cursor.selectionStart(), cursor.selectionEnd());
+
+    if (eagerClipboard)
+    {
+        data->detach();
+        return data;
+    }
+
+    // Документ общий для всех видов вкладки, поэтому данные регистрируются у основного редактора
+    QVector<QPointer<ClipboardMimeData>> &pending = primary ? primary->pendingClipboardData : pendingClipboardData;
+    pending.removeAll(QPointer<ClipboardMimeData>());
+    pending.append(data);
+    return data;
+}
+
+
+// Вызывается при вставке и перетаскивании в редактор. Вставка изменяет документ, поэтому сначала сохраняем буфер.
+void Editor::insertFromMimeData(const QMimeData *source)
+{
+    QTextCursor cursor = textCursor();
+    preserveClipboardSnapshot(cursor.selectionStart(), cursor.selectionEnd());
+    QPlainTextEdit::insertFromMimeData(source);
+}
+
+
+/* Перемещение перетаскиванием внутри редактора сначала удаляет выделение и только потом
+   вставляет данные перетаскивания, поэтому ленивые данные (в том числе сами перетаскиваемые)
+   материализуются до обработки броска.
+ */
+void Editor::dropEvent(QDropEvent *event)
+{
+    preserveClipboardSnapshot();
+    QPlainTextEdit::dropEvent(event);
+}
+
+
+/* Должна вызываться перед любой правкой документа в диапазоне [from, to]. Ленивые данные
+   буфера обмена, чей диапазон затрагивает правка, материализуют свой текст, пока он еще не изменен.
+   Данные, скопированные в любом виде вкладки, хранит основной редактор, поэтому правка
+   в одном виде сохраняет и то, что скопировано в другом.
+ */
+void Editor::preserveClipboardSnapshot(int from, int to)
+{
+    QVector<QPointer<ClipboardMimeData>> &pending = primaryEditor()->pendingClipboardData;
+
+    for (const QPointer<ClipboardMimeData> &data : pending)
+    {
+        if (!data.isNull() && data->intersects(from, to))
+        {
+            data->detach();
+        }
+    }
+
+    pending.removeAll(QPointer<ClipboardMimeData>());
+}
+
+
+/* Сохраняет ленивые данные буфера обмена перед нажатием клавиши, которое изменит документ.
+   Обычная правка с клавиатуры затрагивает только выделение (и соседний символ при удалении).
+   Удаление с модификатором (слово, строка) может уйти дальше, поэтому тогда, как и при отмене,
+   сохраняется все.
+ */
+void Editor::preserveClipboardSnapshot(QKeyEvent *keyEvent)
+{
+    int key = keyEvent->key();
+    bool deletionKey = key == Qt::Key_Backspace || key == Qt::Key_Delete;
+
+    if (keyEvent->matches(QKeySequence::Undo) || keyEvent->matches(QKeySequence::Redo) ||
+        (deletionKey && (keyEvent->modifiers() & ~Qt::KeypadModifier) != Qt::NoModifier))
+    {
+        preserveClipboardSnapshot();
+    }
+    else if ((!keyEvent->text().isEmpty() && keyEvent->text().at(0).isPrint()) ||
+             key == Qt::Key_Enter || key == Qt::Key_Return || key == Qt::Key_Tab ||
+             key == Qt::Key_Backspace || key == Qt::Key_Delete)
+    {
+        QTextCursor cursor = textCursor();
+        preserveClipboardSnapshot(cursor.selectionStart() - 1, cursor.selectionEnd() + 1);
+    }
+}
+
+
+/* Ввод через метод ввода (IME) минует фильтр клавиш. Фиксируемая строка заменяет выделение
+   и, возможно, replacementLength символов от replacementStart относительно курсора.
+ */
+void Editor::inputMethodEvent(QInputMethodEvent *event)
+{
+    if (!event->commitString().isEmpty() || event->replacementLength() > 0)
+    {
+        QTextCursor cursor = textCursor();
+        int from = cursor.selectionStart() + qMin(0, event->replacementStart());
+        int to = cursor.selectionEnd() + qMax(0, event->replacementStart() + event->replacementLength());
+        preserveClipboardSnapshot(from - 1, to + 1);
+    }
+
+    QPlainTextEdit::inputMethodEvent(event);
+}
+
+
+/* Стандартное контекстное меню вызывает слоты внутреннего QWidgetTextControl в обход
+   Editor::cut, undo и redo, поэтому эти пункты переподключаются к редактору.
+ */
+QMenu *Editor::createContextMenu(const QPoint &position)
+{
+    QMenu *menu = createStandardContextMenu(position);
+
+    for (QAction *action : menu->actions())
+    {
+        const char *slot = nullptr;
+
+        if (action->objectName() == "edit-cut")
+        {
+            slot = SLOT(cut());
+        }
+        else if (action->objectName() == "edit-undo")
+        {
+            slot = SLOT(undo());
+        }
+        else if (action->objectName() == "edit-redo")
+        {
+            slot = SLOT(redo());
+        }
+
+        if (slot)
+        {
+            disconnect(action, SIGNAL(triggered(bool)), nullptr, nullptr);
+            connect(action, SIGNAL(triggered()), this, slot);
+        }
+    }
+
+    return menu;
+}
+
+
+// Пункт Delete удаляет выделение в обход редактора, поэтому ленивые данные буфера обмена сохраняются до показа меню.
+void Editor::contextMenuEvent(QContextMenuEvent *event)
+{
+    QMenu *menu = createContextMenu(event->pos());
+    preserveClipboardSnapshot();
+    menu->exec(event->globalPos());
+    delete menu;
+}
+
+
 /* Применяет заданное форматирование к выделенному тексту между двумя указанными индексами (включительно).
    Снимает форматирование со всего текста перед применением заданного форматирования, если флаг указан как true.
    startIndex - индекс, с которого должно начинаться форматирование
@@ -322,10 +645,18 @@ void Editor::formatSubtext(int startIndex, int endIndex, QTextCharFormat format,
 }
 
 
-// Устанавливает режим переноса строк редактора на указанное значение.
+/* Устанавливает режим переноса строк редактора на указанное значение. В разделенной вкладке
+   значение запоминается, но перенос выключен: раскладка документа общая для всех видов,
+   а ширина у них разная.
+ */
 void Editor::setLineWrapMode(LineWrapMode lineWrapMode) {
-    QPlainTextEdit::setLineWrapMode(lineWrapMode);
+    QPlainTextEdit::setLineWrapMode(isSplit() ? LineWrapMode::NoWrap : lineWrapMode);
     this->lineWrapMode = lineWrapMode;
+
+    for (Editor *view : views)
+    {
+        view->QPlainTextEdit::setLineWrapMode(LineWrapMode::NoWrap);
+    }
 }
 
 
@@ -343,6 +674,8 @@ void Editor::toggleAutoIndent(bool autoIndent) {
  */
 void Editor::toggleWrapMode(bool wrap)
 {
+    wrapPending = false;
+
     if (wrap)
     {
         setLineWrapMode(LineWrapMode::WidgetWidth);
@@ -357,80 +690,77 @@ void Editor::toggleWrapMode(bool wrap)
 }
 
 
-/* Вызывается всякий раз, когда содержимое текстового редактора изменяется. Сбрасывает
-   историю поиска редактора, обновляет количество символов и выдает сигнал,
-   чтобы другие объекты (например, MainWindow) могли обновить свои данные соответственно.
+/* Запоминает шрифт для вкладки, которая сейчас не на экране. Смена шрифта заново раскладывает
+   весь документ, поэтому она откладывается до показа вкладки или до простоя (applyPendingFormat).
  */
-void Editor::on_textChanged()
+void Editor::deferFont(const QFont &newFont)
 {
-    searchHistory.clear();
-    updateCharCount();
-    updateWordCount();
-    emit(fileContentsChanged());
+    pendingFont = newFont;
+    fontPending = true;
 }
 
 
-// разбор документа для обновления количества слов. выдает сигнал с количеством слов.
-void Editor::updateWordCount()
+// Запоминает режим переноса для фоновой вкладки; см. deferFont.
+void Editor::deferWrapMode(bool wrap)
+{
+    pendingWrap = wrap;
+    wrapPending = true;
+}
+
+
+// Применяет отложенные шрифт и режим переноса, если они есть.
+void Editor::applyPendingFormat()
 {
-    metrics.wordCount = 0;
-    QString documentContents = toPlainText().toUtf8();
-    int documentLength = documentContents.length();
-    QString currentWord = "";
+    if (!hasPendingFormat())
+    {
+        return;
+    }
 
-    for (int i = 0; i < documentLength; i++)
+    TraceScope trace("Editor::applyPendingFormat", "layout");
+
+    if (fontPending)
     {
-        // Преобразуем в unsigned char, чтобы избежать проблем с утверждениями в отладке
-        unsigned char character = qvariant_cast<unsigned char>(documentContents[i].toLatin1());
+        setFont(pendingFont, QFont::Monospace, true, NUM_CHARS_FOR_TAB);
+    }
 
-        // Символ новой строки
-        if (character == '\n')
-        {
-            // Особый случай: новая строка после слова
-            if (!currentWord.isEmpty())
-            {
-                metrics.wordCount++;
-                currentWord.clear();
-            }
-        }
-        // Все остальные допустимые символы
-        else
-        {
-            // Буквенно-цифровой символ
-            if (isalnum(character))
-            {
-                currentWord += qvariant_cast<char>(character);
-            }
-            // Пробельный символ (исключая новую строку, которая обрабатывается отдельно выше)
-            else if (isspace(character))
-            {
-                // Пробел после слова означает завершение слова
-                if (!currentWord.isEmpty())
-                {
-                    metrics.wordCount++;
-                    currentWord.clear();
-                }
-            }
-        }
+    if (wrapPending)
+    {
+        toggleWrapMode(pendingWrap);
     }
+}
+
 
-    // Например, если мы остановились на слове, которое всё ещё набирается, его нужно учесть
-    if (!currentWord.isEmpty())
+/* Вызывается всякий раз, когда содержимое текстового редактора изменяется. Сбрасывает
+   историю поиска редактора и откладывает подсчет слов и символов до следующего снимка
+   метрик, поэтому серия нажатий за кадр пересчитывает документ один раз.
+ */
+void Editor::on_textChanged()
+{
+    LatencyProbe probe(LatencyMonitor::TextChanged);
+    searchHistory.clear();
+
+    if (!primary)
     {
-        metrics.wordCount++;
-        currentWord.clear();
+        textMetricsStale = true;
+        scheduleMetrics();
     }
+}
+
 
-    emit(wordCountChanged(metrics.wordCount));
+// разбор документа для обновления количества слов.
+void Editor::updateWordCount()
+{
+    TraceScope trace("Editor::updateWordCount", "metrics");
+    metrics.wordCount = Utility::countWords(toPlainText());
 }
 
 
 
-// Обновляет и выдает количество символов.
+// Обновляет количество символов.
 void Editor::updateCharCount()
 {
+    TraceScope trace("Editor::updateCharCount", "metrics");
     metrics.charCount = toPlainText().length();
-    emit(charCountChanged(metrics.charCount));
 }
 
 
@@ -470,9 +800,9 @@ int Editor::indentationLevelOfCurrentLine()
 // Вставляет указанное количество табуляций в документ.
 void Editor::insertTabs(int numTabs)
 {
-    for (int i = 0; i < numTabs; i++)
+    if (numTabs > 0)
     {
-        insertPlainText("\t");
+        insertPlainText(QString(numTabs, '\t'));
     }
 }
 
@@ -481,13 +811,8 @@ void Editor::insertTabs(int numTabs)
 void Editor::moveCursorToStartOfCurrentLine()
 {
     QTextCursor cursor = textCursor();
-
-    do
-    {
-        cursor.movePosition(QTextCursor::Left);
-        setTextCursor(cursor);
-    }
-    while (metrics.currentColumn != 1);
+    cursor.movePosition(QTextCursor::StartOfBlock);
+    setTextCursor(cursor);
 }
 
 
@@ -513,6 +838,106 @@ void Editor::indentSelection(QTextDocumentFragment selection)
 }
 
 
+/* Переотступ всего документа. Для языков с закрывающим разделителем блока (C, C++, Java)
+   уровень строки вычисляется по вложенности скобок, для остальных - по ширине исходного отступа.
+   Документ сохраняет свой стиль: отступленный пробелами остается с пробелами и своим шагом.
+   Также удаляет пробелы в конце строк.
+ */
+void Editor::reindentDocument()
+{
+    QVector<QString> lines = documentLines();
+    Reindenter::IndentStyle style = Reindenter::detectStyle(lines, NUM_CHARS_FOR_TAB);
+    QVector<Reindenter::LineEdit> edits;
+
+    if (usesNestingDelimiters())
+    {
+        edits = Reindenter::reindentByNesting(lines, syntaxHighlighter->getCodeBlockStartDelimiter(),
+                                              syntaxHighlighter->getCodeBlockEndDelimiter(), NUM_CHARS_FOR_TAB, style);
+    }
+    else
+    {
+        edits = Reindenter::reindentByWidth(lines, NUM_CHARS_FOR_TAB, style);
+    }
+
+    applyLineEdits(edits);
+}
+
+
+// Преобразует отступы всех строк в пробелы (useSpaces = true) или табуляции, сохраняя их ширину.
+void Editor::convertIndentation(bool useSpaces)
+{
+    applyLineEdits(Reindenter::convertIndentation(documentLines(), NUM_CHARS_FOR_TAB, useSpaces));
+}
+
+
+// Возвращает true для языков, где блок кода закрывается разделителем (C, C++, Java).
+bool Editor::usesNestingDelimiters() const
+{
+    if (primary)
+    {
+        return primary->usesNestingDelimiters();
+    }
+
+    bool nestingLanguage = programmingLanguage == Language::C || programmingLanguage == Language::CPP ||
+                           programmingLanguage == Language::Java;
+
+    return syntaxHighlighter && nestingLanguage;
+}
+
+
+// Возвращает текст всех блоков документа; вычисление отступов затем идет в других потоках.
+QVector<QString> Editor::documentLines() const
+{
+    QVector<QString> lines;
+    lines.reserve(document()->blockCount());
+
+    for (QTextBlock block = document()->begin(); block.isValid(); block = block.next())
+    {
+        lines.append(block.text());
+    }
+
+    return lines;
+}
+
+
+/* Применяет правки отступов одной пакетной правкой: внутри одного edit block документ
+   выдает один contentsChange и выполняет одну перекладку, а отмена откатывает все разом.
+ */
+void Editor::applyLineEdits(const QVector<Reindenter::LineEdit> &edits)
+{
+    preserveClipboardSnapshot();
+
+    QTextCursor cursor(document());
+    cursor.beginEditBlock();
+
+    int lineNumber = 0;
+    for (QTextBlock block = document()->begin(); block.isValid() && lineNumber < edits.size(); block = block.next(), lineNumber++)
+    {
+        const Reindenter::LineEdit &edit = edits.at(lineNumber);
+
+        if (!edit.changed)
+        {
+            continue;
+        }
+
+        // Сначала конец строки, чтобы позиция начала строки не сдвинулась
+        int blockEnd = block.position() + block.length() - 1;
+        if (edit.trailingLength > 0)
+        {
+            cursor.setPosition(blockEnd - edit.trailingLength);
+            cursor.setPosition(blockEnd, QTextCursor::KeepAnchor);
+            cursor.removeSelectedText();
+        }
+
+        cursor.setPosition(block.position());
+        cursor.setPosition(block.position() + edit.leadingLength, QTextCursor::KeepAnchor);
+        cursor.insertText(edit.indentation);
+    }
+
+    cursor.endEditBlock();
+}
+
+
 // перемещает курсор текста этого редактора в указанную позицию в документе.
 void Editor::moveCursorTo(int positionInText)
 {
@@ -604,7 +1029,16 @@ bool Editor::eventFilter(QObject* obj, QEvent* event)
 {
     if (event->type() == QEvent::KeyPress)
     {
-        int key = static_cast<QKeyEvent*>(event)->key();
+        QKeyEvent *keyEvent = static_cast<QKeyEvent*>(event);
+        int key = keyEvent->key();
+
+        // Правки с клавиатуры не должны испортить ленивые данные буфера обмена
+        if (keyEvent->matches(QKeySequence::Cut))
+        {
+            cut();
+            return true;
+        }
+        preserveClipboardSnapshot(keyEvent);
 
         if (key == Qt::Key_Enter || key == Qt::Key_Return)
         {
@@ -634,21 +1068,242 @@ void Editor::writeSettings()
 }
 
 
-// Загружает ранее сохраненные настройки редактора.
+/* Загружает ранее сохраненные настройки редактора. Вызывается для каждой новой вкладки,
+   поэтому читает типизированные значения из кэша Settings, не обращаясь к QSettings.
+ */
 void Editor::readSettings()
 {
-    settings->apply(settings->value(LINE_WRAP_KEY),
-                    [=](QVariant setting){
-                        LineWrapMode wrap = qvariant_cast<LineWrapMode>(setting);
-                        this->setLineWrapMode(wrap);
-                    }
-                    );
+    if (settings->contains(LINE_WRAP_KEY))
+    {
+        setLineWrapMode(settings->typedValue(LINE_WRAP_KEY, lineWrapMode));
+    }
 
-    settings->apply(settings->value(AUTO_INDENT_KEY),
-                    [=](QVariant setting){
-                        this->autoIndentEnabled = qvariant_cast<bool>(setting);
-                    }
-                    );
+    autoIndentEnabled = settings->typedValue(AUTO_INDENT_KEY, autoIndentEnabled);
+}
+
+
+/* ------------------------------------------------------------
+   Автодополнение по индексу идентификаторов
+  -----------------------------------------------------------
+ */
+
+
+// Вызывается при каждом изменении документа. Передает измененный диапазон индексу идентификаторов.
+void Editor::on_contentsChange(int position, int charsRemoved, int charsAdded)
+{
+    if (releasingCaches)
+    {
+        return;
+    }
+
+    identifierIndex.update(position, charsRemoved, charsAdded);
+
+    // Стеки пусты после setPlainText и clearUndoRedoStacks. Иначе правка попала в стек отмены;
+    // отмена и повтор тоже учитываются как правки, поэтому оценка получается сверху
+    if (document()->availableUndoSteps() + document()->availableRedoSteps() == 0)
+    {
+        undoBytes = 0;
+    }
+    else
+    {
+        undoBytes += (charsRemoved + charsAdded) * qint64(sizeof(QChar)) + UNDO_COMMAND_BYTES;
+    }
+
+    // Загрузка, выгрузка и возврат вкладки не попадают в стек отмены и в журнал тоже.
+    // modificationChanged выдается после contentsChange, поэтому основа - файл до этой правки.
+    // Перечитанный с диска документ совпадает с файлом, поэтому его правки тоже не журналируются
+    // Если документ уже был изменен без журнала (например, стек отмены очищен releaseCaches),
+    // файл на диске не является основой: журнал начинается со снимка, уже содержащего эту правку
+    if (document()->availableUndoSteps() + document()->availableRedoSteps() > 0 && !reloadingFromDisk)
+    {
+        if (!journal->isActive() && document()->isModified())
+        {
+            journal->startFromSnapshot(toPlainText(), fileIsUntitled ? QString() : currentFilePath);
+        }
+        else
+        {
+            if (!journal->isActive())
+            {
+                journal->startFromFile(fileIsUntitled ? QString() : currentFilePath);
+            }
+
+            QTextCursor inserted(document());
+            inserted.setPosition(position);
+            inserted.setPosition(qMin(position + charsAdded, document()->characterCount() - 1), QTextCursor::KeepAnchor);
+            journal->append(position, charsRemoved, inserted.selectedText());
+        }
+
+        journalCompactionTimer->start();
+    }
+
+    // Документ заменен целиком (например, при открытии файла): все блоки новые и видимые
+    bool documentReplaced = position == 0 && charsAdded >= document()->characterCount() - 1;
+
+    if (documentReplaced)
+    {
+        foldedHeaders.clear();
+        laidOutFrom = laidOutTo = 0;
+    }
+    else
+    {
+        // Отрисованный диапазон сдвигается вместе с текстом после места правки
+        int delta = charsAdded - charsRemoved;
+        if (position < laidOutFrom)
+        {
+            laidOutFrom = qMax(position, laidOutFrom + delta);
+        }
+        if (position < laidOutTo)
+        {
+            laidOutTo = qMax(position, laidOutTo + delta);
+        }
+    }
+
+    updateDocumentMemory();
+}
+
+
+/* Сохраненному (или возвращенному отменой к сохраненному) документу журнал не нужен.
+   Выгрузка и возврат вкладки снимают признак изменения только на время setPlainText.
+ */
+void Editor::on_modificationChanged(bool modified)
+{
+    if (!modified && !keepingJournal)
+    {
+        journalCompactionTimer->stop();
+        journal->discard();
+    }
+}
+
+
+// В простое заменяет разросшийся журнал сжатым снимком текста. Выгруженная вкладка текста не имеет.
+void Editor::compactJournal()
+{
+    if (journal->needsCompaction() && !isHibernated())
+    {
+        journal->compact(toPlainText());
+    }
+}
+
+
+/* Начинает журнал вкладки, текст которой восстановлен из журнала прошлого запуска: основой
+   становится снимок этого текста, так как файл на диске его не содержит.
+ */
+void Editor::journalRecoveredText()
+{
+    primaryEditor()->journal->startFromSnapshot(toPlainText(), fileIsUntitled ? QString() : currentFilePath);
+}
+
+
+/* Пока открыт список дополнений, Enter, Tab и Escape обрабатывает QCompleter.
+   Ctrl+Space принудительно открывает список; после остальных клавиш он обновляется.
+ */
+void Editor::keyPressEvent(QKeyEvent *event)
+{
+    if (completer->popup()->isVisible())
+    {
+        switch (event->key())
+        {
+            case Qt::Key_Enter:
+            case Qt::Key_Return:
+            case Qt::Key_Escape:
+            case Qt::Key_Tab:
+            case Qt::Key_Backtab:
+                event->ignore();
+                return;
+            default:
+                break;
+        }
+    }
+
+    bool forceCompletion = event->modifiers() == Qt::ControlModifier && event->key() == Qt::Key_Space;
+
+    if (LatencyMonitor::isEnabled())
+    {
+        LatencyMonitor::instance()->keyPressed();
+    }
+
+    if (!forceCompletion)
+    {
+        // Клавиши, пересланные из списка дополнений, минуют eventFilter
+        preserveClipboardSnapshot(event);
+
+        // Правка документа синхронно раскладывает и подсвечивает измененные блоки
+        LatencyProbe probe(LatencyMonitor::EditAndLayout);
+        QPlainTextEdit::keyPressEvent(event);
+    }
+
+    bool typedText = !event->text().isEmpty() && event->text().at(0).isPrint();
+    if (forceCompletion || typedText || completer->popup()->isVisible())
+    {
+        updateCompletionPopup(forceCompletion);
+    }
+}
+
+
+// Возвращает часть идентификатора слева от курсора.
+QString Editor::identifierPrefixUnderCursor() const
+{
+    QTextCursor cursor = textCursor();
+    QString blockText = cursor.block().text();
+    int end = cursor.positionInBlock();
+    int start = end;
+
+    while (start > 0 && (blockText.at(start - 1).isLetterOrNumber() || blockText.at(start - 1) == '_'))
+    {
+        start--;
+    }
+
+    return blockText.mid(start, end - start);
+}
+
+
+/* Показывает, обновляет или скрывает список дополнений для идентификатора под курсором.
+   Без явного запроса (Ctrl+Space) список появляется только для префикса минимальной длины.
+ */
+void Editor::updateCompletionPopup(bool forced)
+{
+    QString prefix = identifierPrefixUnderCursor();
+    bool prefixTooShort = prefix.length() < IdentifierIndex::MIN_IDENTIFIER_LENGTH;
+
+    if (prefix.isEmpty() || (prefixTooShort && !forced) || prefix.at(0).isDigit())
+    {
+        completer->popup()->hide();
+        return;
+    }
+
+    QStringList completions = primaryEditor()->identifierIndex.complete(prefix, MAX_COMPLETIONS);
+
+    if (completions.isEmpty())
+    {
+        completer->popup()->hide();
+        return;
+    }
+
+    completer->setCompletionPrefix(prefix);
+    completionModel->setStringList(completions);
+    completer->popup()->setCurrentIndex(completionModel->index(0, 0));
+
+    QRect popupRect = cursorRect();
+    popupRect.setWidth(completer->popup()->sizeHintForColumn(0) +
+                       completer->popup()->verticalScrollBar()->sizeHint().width());
+    completer->complete(popupRect);
+}
+
+
+// Вызывается, когда пользователь выбирает вариант дополнения. Дописывает недостающую часть идентификатора.
+void Editor::insertCompletion(QString completion)
+{
+    QString prefix = identifierPrefixUnderCursor();
+
+    if (!completion.startsWith(prefix))
+    {
+        return;
+    }
+
+    QTextCursor cursor = textCursor();
+    preserveClipboardSnapshot(cursor.position(), cursor.position());
+    cursor.insertText(completion.mid(prefix.length()));
+    setTextCursor(cursor);
 }
 
 
@@ -658,120 +1313,795 @@ void Editor::readSettings()
  */
 
 
-/* возвращает ширину области номеров строк редактора, вычисляя количество цифр в номере
-   последней строки, умножая это значение на максимальную ширину любой цифры,
-   и добавляет фиксированный размер отступа.
- */
-int Editor::getLineNumberAreaWidth()
-{
-    int lastLineNumber = blockCount();
-    int numDigitsInLastLine = QString::number(lastLineNumber).length();
-    int maxWidthOfAnyDigit = fontMetrics().horizontalAdvance(QLatin1Char('9')); // 9 выбрана произвольно
-    return numDigitsInLastLine * maxWidthOfAnyDigit + lineNumberAreaPadding;
+/* возвращает ширину области номеров строк редактора, вычисляя количество цифр в номере
+   последней строки, умножая это значение на максимальную ширину любой цифры,
+   и добавляет фиксированный размер отступа. Обе величины кэшируются.
+ */
+int Editor::getLineNumberAreaWidth()
+{
+    return lineNumberDigits * gutterRenderer.getMaxDigitWidth() + lineNumberAreaPadding + foldMarkerWidth;
+}
+
+
+/* вызывается, когда пользователь изменяет количество блоков (абзацев) в документе.
+   Ширина поля пересчитывается только тогда, когда меняется количество цифр в номере последней строки.
+ */
+void Editor::updateLineNumberAreaWidth()
+{
+    int digits = GutterRenderer::numDigits(blockCount());
+
+    if (digits == lineNumberDigits)
+    {
+        return;
+    }
+
+    lineNumberDigits = digits;
+    setViewportMargins(getLineNumberAreaWidth() + lineNumberAreaPadding, 0, Minimap::MINIMAP_WIDTH, 0);
+    layoutSideWidgets();
+}
+
+
+// Размещает область номеров строк слева от области просмотра, а миникарту - справа от нее.
+void Editor::layoutSideWidgets()
+{
+    QRect cr = contentsRect();
+    lineNumberArea->setGeometry(QRect(cr.left(), cr.top(), getLineNumberAreaWidth(), cr.height()));
+    minimap->setGeometry(QRect(viewport()->geometry().right() + 1, cr.top(), Minimap::MINIMAP_WIDTH, cr.height()));
+}
+
+
+// Перестраивает кэш глифов номеров строк после смены шрифта или масштаба и пересчитывает ширину поля.
+void Editor::refreshGutterMetrics()
+{
+    if (gutterRenderer.setFont(QPlainTextEdit::font()))
+    {
+        lineNumberDigits = 0;
+        updateLineNumberAreaWidth();
+        lineNumberArea->update();
+    }
+}
+
+
+// Вызывается, когда область просмотра редактора прокручивается. Перерисовывает только изменившуюся часть области номеров строк.
+void Editor::redrawLineNumberArea(const QRect &rectToBeRedrawn, int numPixelsScrolledVertically)
+{
+    if (numPixelsScrolledVertically != 0)
+    {
+        lineNumberArea->scroll(0, numPixelsScrolledVertically);
+
+        // Нарисованная полоса текущей строки прокручивается вместе с содержимым
+        highlightedLineRect.translate(0, numPixelsScrolledVertically);
+        minimap->update();
+    }
+    else
+    {
+        lineNumberArea->update(0, rectToBeRedrawn.y(), lineNumberArea->width(), rectToBeRedrawn.height());
+    }
+}
+
+
+// Вызывается, когда редактор изменяет размер. Изменяет размер области номеров строк и миникарты соответственно.
+void Editor::resizeEvent(QResizeEvent *event)
+{
+    QPlainTextEdit::resizeEvent(event);
+    layoutSideWidgets();
+}
+
+
+// Вызывается при смене шрифта (в том числе при масштабировании), чтобы обновить кэш номеров строк.
+void Editor::changeEvent(QEvent *event)
+{
+    QPlainTextEdit::changeEvent(event);
+
+    if (event->type() == QEvent::FontChange)
+    {
+        refreshGutterMetrics();
+    }
+}
+
+
+/* Вкладка снова на экране: применяем отложенные шрифт и перенос до первой отрисовки
+   и возвращаем подсветку, снятую releaseCaches.
+ */
+void Editor::showEvent(QShowEvent *event)
+{
+    applyPendingFormat();
+    QPlainTextEdit::showEvent(event);
+
+    if (formatsReleased)
+    {
+        formatsReleased = false;
+        syntaxHighlighter->setDocument(document());
+    }
+}
+
+
+// Запоминает, когда вкладка ушла в фон.
+void Editor::hideEvent(QHideEvent *event)
+{
+    QPlainTextEdit::hideEvent(event);
+    hiddenSince.start();
+}
+
+
+// Сколько миллисекунд вкладка не показывается (0 для видимой вкладки).
+qint64 Editor::idleMilliseconds() const
+{
+    return isVisible() || !hiddenSince.isValid() ? 0 : hiddenSince.elapsed();
+}
+
+
+/* ------------------------------------------------------------
+   Учет памяти
+  -----------------------------------------------------------
+ */
+
+
+/* Оценивает память вкладки и запоминает замер (см. getMemoryUsage). Документ здесь не обходится:
+   текст, раскладка, форматы и стек отмены поддерживаются on_contentsChange (см. updateDocumentMemory),
+   а заново считаются только история поиска и индекс автодополнения.
+ */
+MemoryUsage Editor::measureMemoryUsage()
+{
+    TraceScope trace("Editor::measureMemoryUsage", "memory");
+
+    updateDocumentMemory();
+    memory.search = searchHistory.memoryUsage() + identifierIndex.memoryUsage();
+    return memory;
+}
+
+
+// Расширяет отрисованный диапазон позиций [from, to) для оценки раскладки.
+void Editor::noteLaidOut(int from, int to)
+{
+    if (laidOutTo <= laidOutFrom)
+    {
+        laidOutFrom = from;
+        laidOutTo = to;
+    }
+    else
+    {
+        laidOutFrom = qMin(laidOutFrom, from);
+        laidOutTo = qMax(laidOutTo, to);
+    }
+}
+
+
+/* Обновляет в замере текст, раскладку, форматы и стек отмены без обхода блоков. QTextBlock::layout()
+   создает раскладку блоку, у которого ее нет, поэтому раскладка оценивается по отрисованному
+   диапазону (прокрученная до конца вкладка весит больше свежеоткрытой), а форматы - по тому,
+   подключен ли подсветчик к документу.
+ */
+void Editor::updateDocumentMemory()
+{
+    QTextDocument *document = this->document();
+    int characters = document->characterCount();
+
+    memory.text = characters * qint64(sizeof(QChar)) + document->blockCount() * qint64(BLOCK_BYTES);
+    memory.layout = minimap->memoryUsage();
+    memory.formats = syntaxHighlighter && !formatsReleased ? characters * qint64(FORMAT_BYTES_PER_CHAR) : 0;
+    memory.undo = undoBytes;
+
+    int laidOutEnd = qMin(laidOutTo, characters);
+    if (laidOutEnd > laidOutFrom)
+    {
+        int lines = document->findBlock(laidOutEnd - 1).blockNumber() - document->findBlock(laidOutFrom).blockNumber() + 1;
+        memory.layout += (laidOutEnd - laidOutFrom) * qint64(GLYPH_BYTES_PER_CHAR) + lines * qint64(LINE_BYTES);
+    }
+
+    if (hibernated)
+    {
+        memory.text += hibernated->memoryUsage();
+    }
+}
+
+
+/* Освобождает кэши фоновой вкладки: раскладку блоков, форматы подсветки и плитки миникарты.
+   Раскладка восстанавливается лениво при отрисовке, подсветка - при следующем показе вкладки.
+   QTextDocument не умеет обрезать стек отмены частично, поэтому история, в которой больше
+   undoStepsToKeep шагов, удаляется целиком.
+ */
+void Editor::releaseCaches(int undoStepsToKeep)
+{
+    TraceScope trace("Editor::releaseCaches", "memory");
+
+    // По последнему замеру освобождать нечего: не проходим документ повторно
+    if (memory.layout + memory.formats > 0)
+    {
+        releasingCaches = true;
+
+        // Отключенный подсветчик снимает форматы со всех блоков, а изменение всего документа
+        // заставляет QPlainTextDocumentLayout сбросить раскладку каждого блока
+        if (syntaxHighlighter && !formatsReleased)
+        {
+            syntaxHighlighter->setDocument(nullptr);
+            formatsReleased = true;
+        }
+        else
+        {
+            document()->markContentsDirty(0, document()->characterCount());
+        }
+
+        releasingCaches = false;
+        laidOutFrom = laidOutTo = 0;
+        minimap->releaseTiles();
+    }
+
+    if (document()->availableUndoSteps() > undoStepsToKeep)
+    {
+        document()->clearUndoRedoStacks();
+        undoBytes = 0;
+    }
+
+    measureMemoryUsage();
+}
+
+
+/* Выгружает фоновую вкладку: текст, курсор, прокрутка, свернутые регионы и признак изменения
+   сохраняются в HibernatedTab, а документ очищается, освобождая блоки, раскладку, форматы
+   и стек отмены. Сам QTextDocument и подсветчик остаются, поэтому вкладка не теряет
+   подключения; история отмены при выгрузке теряется, так как Qt не умеет ее сохранять.
+   Возвращает false для видимой или уже выгруженной вкладки.
+ */
+bool Editor::hibernate()
+{
+    if (hibernated || isVisible())
+    {
+        return false;
+    }
+
+    TraceScope trace("Editor::hibernate", "memory");
+
+    // Буфер обмена может ссылаться на документ, который сейчас будет очищен
+    preserveClipboardSnapshot();
+
+    HibernatedTab *state = new HibernatedTab();
+    QTextCursor cursor = textCursor();
+    state->cursorAnchor = cursor.anchor();
+    state->cursorPosition = cursor.position();
+    state->verticalScroll = verticalScrollBar()->value();
+    state->horizontalScroll = horizontalScrollBar()->value();
+    state->modified = document()->isModified();
+
+    for (const QTextCursor &header : foldedHeaders)
+    {
+        state->foldedHeaders.append(header.blockNumber());
+    }
+
+    state->store(toPlainText());
+
+    keepingJournal = true;
+    setPlainText(QString());
+    document()->setModified(state->modified);
+    keepingJournal = false;
+    minimap->releaseTiles();
+
+    hibernated = state;
+    measureMemoryUsage();
+    return true;
+}
+
+
+/* Делает вкладку заглушкой для файла из сессии: файл будет прочитан при первом показе
+   вкладки (см. rehydrate), а курсор поставлен в cursorPosition.
+ */
+void Editor::deferLoading(const QString &filePath, int cursorPosition)
+{
+    delete hibernated;
+    hibernated = new HibernatedTab();
+    hibernated->filePath = filePath;
+    hibernated->cursorAnchor = cursorPosition;
+    hibernated->cursorPosition = cursorPosition;
+    setCurrentFilePath(filePath);
+}
+
+
+/* Читает файл вкладки, отложенной deferLoading, в пуле потоков и загружает его в документ,
+   как только чтение закончится, не дожидаясь показа вкладки. Если вкладку показали раньше,
+   ее уже загрузил rehydrate. Если файл не удалось прочитать, выдается loadFailed.
+ */
+void Editor::loadInBackground()
+{
+    if (!hibernated)
+    {
+        return;
+    }
+
+    auto *watcher = new QFutureWatcher<QPair<bool, QString>>(this);
+    connect(watcher, &QFutureWatcherBase::finished, this, [this, watcher]() {
+        watcher->deleteLater();
+
+        if (isHibernated())
+        {
+            rehydrate();
+        }
+    });
+    watcher->setFuture(hibernated->prefetch());
+}
+
+
+/* Запоминает состояние файла вкладки на диске после его чтения или сохранения, чтобы
+   FileWatcher отличал внешние изменения от собственных. Заодно возобновляет слежение:
+   при первом сохранении файла раньше не существовало.
+ */
+void Editor::syncDiskState()
+{
+    if (primary)
+    {
+        primary->syncDiskState();
+        return;
+    }
+
+    disk = fileIsUntitled ? DiskState() : DiskState::read(currentFilePath);
+    FileWatcher::instance()->watch(this, fileIsUntitled ? QString() : currentFilePath);
+}
+
+
+/* Перечитывает изменившийся на диске файл вкладки. Если файл только дописан (например, журнал
+   программы), читаются лишь новые байты и добавляются в конец документа. Иначе файл читается,
+   и построчная разность с документом считается в пуле потоков; затем применяются только
+   измененные строки, поэтому курсор, прокрутка, свернутые регионы и подсветка остальных строк
+   сохраняются. Несохраненные правки отбрасываются только при discardChanges.
+   Выгруженная вкладка просто перечитает файл при показе.
+ */
+void Editor::reloadFromDisk(bool discardChanges)
+{
+    if (primary)
+    {
+        primary->reloadFromDisk(discardChanges);
+        return;
+    }
+
+    if (!changedOnDisk() || (isUnsaved() && !discardChanges))
+    {
+        return;
+    }
+
+    if (hibernated)
+    {
+        hibernated->discardText(currentFilePath);
+        disk = DiskState();
+        document()->setModified(false);
+        return;
+    }
+
+    // Разность уже считается: файл будет проверен еще раз, когда она будет применена
+    if (diskReload)
+    {
+        diskReloadQueued = true;
+        return;
+    }
+
+    if (!isUnsaved() && appendFromDisk())
+    {
+        return;
+    }
+
+    TraceScope trace("Editor::reloadFromDisk", "io");
+    int revision = document()->revision();
+    QVector<QString> lines = documentLines();
+    QString filePath = currentFilePath;
+
+    diskReload = new QFutureWatcher<DiskReload>(this);
+    connect(diskReload, &QFutureWatcherBase::finished, this, [this, revision, discardChanges]() {
+        DiskReload result = diskReload->result();
+        diskReload->deleteLater();
+        diskReload = nullptr;
+
+        // Документ правили, пока считалась разность: она устарела
+        bool stale = document()->revision() != revision;
+
+        if (result.ok && !stale)
+        {
+            applyHunks(result.hunks);
+            document()->setModified(false);
+            disk = result.disk;
+        }
+
+        if (stale || diskReloadQueued)
+        {
+            diskReloadQueued = false;
+            reloadFromDisk(discardChanges);
+        }
+    });
+
+    // Состояние снимается до чтения: если файл изменится во время чтения, изменение не потеряется
+    diskReload->setFuture(QtConcurrent::run([filePath, lines]() {
+        DiskReload reload;
+        reload.disk = DiskState::read(filePath);
+
+        QFile file(filePath);
+        if (reload.disk.size < 0 || !file.open(QIODevice::ReadOnly | QFile::Text))
+        {
+            return reload;
+        }
+
+        QTextStream in(&file);
+        reload.hunks = LineDiff::diff(lines, in.readAll().split('\n').toVector());
+        reload.ok = true;
+        return reload;
+    }));
+}
+
+
+/* Добавляет в конец документа байты, дописанные в файл после последнего чтения. Возвращает
+   false, если файл не только дописан: он стал короче или изменились байты перед прежним концом.
+   Если конец документа был виден, прокрутка следует за новыми строками.
+ */
+bool Editor::appendFromDisk()
+{
+    QFileInfo info(currentFilePath);
+    QFile file(currentFilePath);
+    qint64 size = info.size();
+
+    if (disk.size < 0 || size <= disk.size || !file.open(QIODevice::ReadOnly))
+    {
+        return false;
+    }
+
+    if (!file.seek(disk.size - disk.tail.size()) || file.read(disk.tail.size()) != disk.tail)
+    {
+        return false;
+    }
+
+    QByteArray appended = file.read(size - disk.size);
+
+    // Как и при открытии файла: кодировка локали и переводы строк без '\r'
+    if (!disk.decoder)
+    {
+        disk.decoder.reset(QTextCodec::codecForLocale()->makeDecoder());
+    }
+    QString text = disk.decoder->toUnicode(appended);
+    text.remove('\r');
+
+    bool following = verticalScrollBar()->value() == verticalScrollBar()->maximum();
+
+    reloadingFromDisk = true;
+    QTextCursor cursor(document());
+    cursor.movePosition(QTextCursor::End);
+    cursor.insertText(text);
+    reloadingFromDisk = false;
+    document()->setModified(false);
+
+    if (following)
+    {
+        verticalScrollBar()->setValue(verticalScrollBar()->maximum());
+    }
+
+    disk.size += appended.size();
+    disk.modified = info.lastModified();
+    disk.tail = (disk.tail + appended).right(DiskState::TAIL_BYTES);
+    return true;
+}
+
+
+/* Применяет куски построчной разности одной пакетной правкой, с последнего к первому, чтобы
+   номера строк еще не примененных кусков не сдвигались. Первая видимая строка запоминается
+   курсором: документ сдвигает его вместе с правками выше.
+ */
+void Editor::applyHunks(const QVector<LineDiff::Hunk> &hunks)
+{
+    if (hunks.isEmpty())
+    {
+        return;
+    }
+
+    preserveClipboardSnapshot();
+    QTextCursor top(firstVisibleBlock());
+    int horizontalScroll = horizontalScrollBar()->value();
+
+    reloadingFromDisk = true;
+    QTextCursor cursor(document());
+    cursor.beginEditBlock();
+
+    for (int i = hunks.size() - 1; i >= 0; i--)
+    {
+        const LineDiff::Hunk &hunk = hunks.at(i);
+        QString text = QStringList(QList<QString>::fromVector(hunk.newLines)).join('\n');
+        QTextBlock first = document()->findBlockByNumber(hunk.oldStart);
+
+        // Вставка строк без удаления: перед строкой oldStart или после последней строки
+        if (hunk.oldCount == 0)
+        {
+            if (first.isValid())
+            {
+                cursor.setPosition(first.position());
+                cursor.insertText(text + '\n');
+            }
+            else
+            {
+                cursor.movePosition(QTextCursor::End);
+                cursor.insertText('\n' + text);
+            }
+            continue;
+        }
+
+        QTextBlock last = document()->findBlockByNumber(hunk.oldStart + hunk.oldCount - 1);
+        int start = first.position();
+        int end = last.position() + last.length() - 1;
+
+        // Строки удаляются целиком вместе с одним из соседних переводов строки
+        if (hunk.newLines.isEmpty())
+        {
+            if (last.next().isValid())
+            {
+                end = last.next().position();
+            }
+            else if (first.previous().isValid())
+            {
+                start--;
+            }
+        }
+
+        cursor.setPosition(start);
+        cursor.setPosition(end, QTextCursor::KeepAnchor);
+        cursor.insertText(text);
+    }
+
+    cursor.endEditBlock();
+    reloadingFromDisk = false;
+
+    verticalScrollBar()->setValue(top.block().firstLineNumber());
+    horizontalScrollBar()->setValue(horizontalScroll);
 }
 
 
-/* вызывается, когда пользователь изменяет количество блоков (абзацев) в документе.
-   обновляет левое поле редактора так, чтобы его ширина соответствовала самой широкой строке номера.
+/* Возвращает выгруженной вкладке текст и состояние. Подсветчик на время вставки текста
+   отключается: после повторного подключения он перекрашивает документ отложенно,
+   поэтому текст появляется без ожидания подсветки. Возвращает false, если файл
+   вкладки из сессии не удалось прочитать; вкладка тогда остается пустой и выдается loadFailed.
  */
-void Editor::updateLineNumberAreaWidth()
+bool Editor::rehydrate()
 {
-    setViewportMargins(getLineNumberAreaWidth() + lineNumberAreaPadding, 0, 0, 0);
-}
+    if (!hibernated)
+    {
+        return true;
+    }
 
+    TraceScope trace("Editor::rehydrate", "memory");
+    HibernatedTab *state = hibernated;
+    hibernated = nullptr;
 
-// Вызывается, когда область просмотра редактора прокручивается. Перерисовывает область номеров строк соответственно.
-void Editor::redrawLineNumberArea(const QRect &rectToBeRedrawn, int numPixelsScrolledVertically)
-{
-    if (numPixelsScrolledVertically != 0)
+    bool detachHighlighter = syntaxHighlighter && !formatsReleased;
+    if (detachHighlighter)
     {
-        lineNumberArea->scroll(0, numPixelsScrolledVertically);
+        syntaxHighlighter->setDocument(nullptr);
+    }
+
+    bool fromFile = !state->filePath.isEmpty();
+    bool loaded = false;
+    keepingJournal = true;
+    setPlainText(state->load(&loaded));
+
+    if (detachHighlighter)
+    {
+        syntaxHighlighter->setDocument(document());
+    }
+    else if (!syntaxHighlighter)
+    {
+        syntaxHighlighter = generateHighlighterFor(programmingLanguage, document());
+    }
+
+    document()->setModified(state->modified);
+    keepingJournal = false;
+
+    if (fromFile && loaded)
+    {
+        syncDiskState();
+    }
+
+    // Файл из сессии мог измениться на диске, поэтому позиции ограничиваются концом документа
+    int lastPosition = document()->characterCount() - 1;
+    QTextCursor cursor(document());
+    cursor.setPosition(qBound(0, state->cursorAnchor, lastPosition));
+    cursor.setPosition(qBound(0, state->cursorPosition, lastPosition), QTextCursor::KeepAnchor);
+    setTextCursor(cursor);
+
+    for (int number : state->foldedHeaders)
+    {
+        QTextBlock header = document()->findBlockByNumber(number);
+        if (header.isValid() && !isFolded(header))
+        {
+            fold(header);
+        }
+    }
+
+    if (state->verticalScroll < 0)
+    {
+        centerCursor();
     }
     else
     {
-        lineNumberArea->update(0, rectToBeRedrawn.y(), lineNumberArea->width(), rectToBeRedrawn.height());
+        verticalScrollBar()->setValue(state->verticalScroll);
+        horizontalScrollBar()->setValue(state->horizontalScroll);
     }
 
-    if (rectToBeRedrawn.contains(viewport()->rect()))
+    delete state;
+    measureMemoryUsage();
+
+    if (!loaded)
     {
-        updateLineNumberAreaWidth();
+        emit loadFailed();
     }
+    return loaded;
 }
 
 
-// Вызывается, когда редактор изменяет размер. Изменяет размер области номеров строк соответственно.
-void Editor::resizeEvent(QResizeEvent *event)
+/* Вызывается, когда курсор изменяет позицию. Перерисовывает только полосы старой и новой
+   текущей строки, а обновление строки состояния откладывает до следующего кадра.
+ */
+void Editor::on_cursorPositionChanged()
 {
-    QPlainTextEdit::resizeEvent(event);
+    LatencyProbe probe(LatencyMonitor::CursorPositionChanged);
 
-    QRect cr = contentsRect();
-    lineNumberArea->setGeometry(QRect(cr.left(), cr.top(), getLineNumberAreaWidth(), cr.height()));
+    // Поиск или переход к строке могли привести курсор внутрь свернутого региона
+    if (!textCursor().block().isVisible())
+    {
+        revealBlock(textCursor().block());
+    }
+
+    highlightCurrentLine();
+
+    metrics.currentLine = textCursor().blockNumber() + 1;
+    metrics.totalLines = document()->lineCount();
+    metrics.currentColumn = textCursor().positionInBlock() + 1;
+    scheduleMetrics();
 }
 
 
-// Вызывается, когда курсор изменяет позицию.
-void Editor::on_cursorPositionChanged()
+// Запускает таймер снимка метрик, если он еще не запущен в этом кадре.
+void Editor::scheduleMetrics()
 {
-    highlightCurrentLine();
+    if (!metricsTimer->isActive())
+    {
+        metricsTimer->start();
+    }
+}
+
+
+/* Выдает один снимок метрик с изменениями, накопленными за кадр. Слова и символы
+   пересчитываются, только если за это время менялся текст.
+ */
+void Editor::emitMetrics()
+{
+    TraceScope trace("Editor::emitMetrics", "metrics");
+    metricsTimer->stop();
+
+    if (textMetricsStale)
+    {
+        updateCharCount();
+        updateWordCount();
+        textMetricsStale = false;
+    }
+
     updateLineCount();
     updateColumnCount();
+    emit metricsChanged(metrics);
 }
 
 
-// Обновляет и выдает количество строк (текущих и общих).
+// Обновляет количество строк (текущих и общих).
 void Editor::updateLineCount()
 {
     metrics.currentLine = textCursor().blockNumber() + 1;
     metrics.totalLines = document()->lineCount();
-    emit(lineCountChanged(metrics.currentLine, metrics.totalLines));
 }
 
 
-// Обновляет и выдает количество колонок.
+// Обновляет количество колонок.
 void Editor::updateColumnCount()
 {
     metrics.currentColumn = textCursor().positionInBlock() + 1;
-    emit(columnCountChanged(metrics.currentColumn));
 }
 
 
-// Подсвечивает текущую строку. См. вызов on_cursorPositionChanged().
+/* Подсвечивает текущую строку. См. вызов on_cursorPositionChanged(). Вместо пересоздания
+   ExtraSelections (что перерисовывает всю область просмотра) помечает грязными только
+   прямоугольники старой и новой строки; сама полоса рисуется в paintEvent.
+ */
 void Editor::highlightCurrentLine()
 {
-    QList<QTextEdit::ExtraSelection> extraSelections;
-    if (!isReadOnly())
+    QRect newLineRect = currentLineRect();
+
+    if (newLineRect == highlightedLineRect)
+    {
+        return;
+    }
+
+    viewport()->update(highlightedLineRect);
+    viewport()->update(newLineRect);
+}
+
+
+// Возвращает прямоугольник визуальной строки с курсором во всю ширину области просмотра.
+QRect Editor::currentLineRect() const
+{
+    if (isReadOnly())
+    {
+        return QRect();
+    }
+
+    QRect cursorLine = cursorRect();
+    return QRect(0, cursorLine.top(), viewport()->width(), cursorLine.height());
+}
+
+
+/* Рисует полосу текущей строки под текстом, затем передает отрисовку QPlainTextEdit.
+   Фон области просмотра уже залит, поэтому полоса остается под текстом и выделением.
+ */
+void Editor::paintEvent(QPaintEvent *event)
+{
+    LatencyProbe probe(LatencyMonitor::FramePaint);
+    highlightedLineRect = currentLineRect();
+
+    if (highlightedLineRect.intersects(event->rect()))
+    {
+        QPainter painter(viewport());
+        painter.fillRect(highlightedLineRect.intersected(event->rect()), LINE_COLOR);
+    }
+
+    QPlainTextEdit::paintEvent(event);
+
+    // Отрисованные блоки теперь разложены: учитываем их в оценке памяти вкладки
+    QTextBlock lastVisible = cursorForPosition(viewport()->rect().bottomRight()).block();
+    primaryEditor()->noteLaidOut(firstVisibleBlock().position(), lastVisible.position() + lastVisible.length());
+
+    if (LatencyMonitor::isEnabled())
     {
-        QTextEdit::ExtraSelection selection;
-        selection.format.setBackground(LINE_COLOR);
-        selection.format.setProperty(QTextFormat::FullWidthSelection, true);
-        selection.cursor = textCursor();
-        selection.cursor.clearSelection();
-        extraSelections.append(selection);
+        LatencyMonitor::instance()->framePainted();
     }
-    setExtraSelections(extraSelections);
 }
 
 
-/* См. linenumberarea.h для вызова. Перебирает каждый блок (абзац/строку) в
-   редакторе и рисует соответствующие номера строк в lineNumberArea.
+/* См. linenumberarea.h для вызова. Перебирает видимые блоки (абзацы/строки) в
+   редакторе и рисует соответствующие номера строк в lineNumberArea из кэшированных глифов цифр.
  */
 void Editor::lineNumberAreaPaintEvent(QPaintEvent *event)
 {
+    LatencyProbe probe(LatencyMonitor::LineNumberPaint);
     QPainter painter(lineNumberArea);
+    painter.setFont(gutterRenderer.getFont());
+    painter.setPen(Qt::black);
+    painter.setBrush(Qt::darkGray);
 
     QTextBlock block = firstVisibleBlock();
     int blockNumber = block.blockNumber();
     int top = qvariant_cast<int>(blockBoundingGeometry(block).translated(contentOffset()).top());
     int bottom = top + qvariant_cast<int>(blockBoundingRect(block).height());
+    int right = lineNumberArea->width() - foldMarkerWidth;
+
+    Folding::Delimiters delimiters = foldingDelimiters();
+    int markerHalfSize = qMin(foldMarkerWidth, gutterRenderer.getLineHeight()) / 4;
+    int markerCenterX = right + foldMarkerWidth / 2;
 
     // перебирает каждый блок (абзац) и рисует его соответствующий номер
     while (block.isValid() && top <= event->rect().bottom())
     {
         if (block.isVisible() && bottom >= event->rect().top())
         {
-            QString lineNumber = QString::number(blockNumber + 1);
-            painter.setPen(Qt::black);
-            painter.drawText(0, top, lineNumberArea->width(), fontMetrics().height(), Qt::AlignRight, lineNumber);
+            gutterRenderer.drawNumber(painter, blockNumber + 1, right, top);
+
+            // Маркер сворачивания: треугольник вправо для свернутого региона, вниз - для развернутого
+            if (Folding::startsRegion(block, delimiters) || isFolded(block))
+            {
+                int centerY = top + gutterRenderer.getLineHeight() / 2;
+                QPolygon marker;
+
+                if (isFolded(block))
+                {
+                    marker << QPoint(markerCenterX - markerHalfSize, centerY - 2 * markerHalfSize)
+                           << QPoint(markerCenterX + markerHalfSize, centerY)
+                           << QPoint(markerCenterX - markerHalfSize, centerY + 2 * markerHalfSize);
+                }
+                else
+                {
+                    marker << QPoint(markerCenterX - 2 * markerHalfSize, centerY - markerHalfSize)
+                           << QPoint(markerCenterX + 2 * markerHalfSize, centerY - markerHalfSize)
+                           << QPoint(markerCenterX, centerY + markerHalfSize);
+                }
+
+                painter.drawPolygon(marker);
+            }
         }
 
         block = block.next();
@@ -782,3 +2112,251 @@ void Editor::lineNumberAreaPaintEvent(QPaintEvent *event)
 }
 
 
+// Щелчок по колонке маркеров сворачивания сворачивает или разворачивает регион этой строки.
+void Editor::lineNumberAreaMousePressEvent(QMouseEvent *event)
+{
+    if (event->button() != Qt::LeftButton || event->pos().x() < lineNumberArea->width() - foldMarkerWidth)
+    {
+        return;
+    }
+
+    toggleFold(cursorForPosition(QPoint(0, event->pos().y())).block());
+}
+
+
+/* ------------------------------------------------------------
+   Все функции ниже этой строки используются для сворачивания кода
+  -----------------------------------------------------------
+ */
+
+
+// Регионы определяются скобками для языков с закрывающим разделителем блока, иначе - отступами.
+Folding::Delimiters Editor::foldingDelimiters() const
+{
+    Folding::Delimiters delimiters;
+    delimiters.tabWidth = NUM_CHARS_FOR_TAB;
+
+    if (usesNestingDelimiters())
+    {
+        delimiters.open = syntaxHighlighter->getCodeBlockStartDelimiter();
+        delimiters.close = syntaxHighlighter->getCodeBlockEndDelimiter();
+    }
+
+    return delimiters;
+}
+
+
+// Регион свернут, если его заголовок виден, а следующая за ним строка скрыта.
+bool Editor::isFolded(const QTextBlock &block) const
+{
+    return block.isVisible() && block.next().isValid() && !block.next().isVisible();
+}
+
+
+// Сворачивает регион, начинающийся со строки header, или разворачивает его, если он уже свернут.
+void Editor::toggleFold(QTextBlock header)
+{
+    // Видимость блоков общая для всех видов документа, поэтому сворачиванием управляет основной редактор
+    if (primary)
+    {
+        primary->toggleFold(header);
+        return;
+    }
+
+    if (!header.isValid() || !header.isVisible())
+    {
+        return;
+    }
+
+    if (isFolded(header))
+    {
+        unfold(header);
+    }
+    else
+    {
+        fold(header);
+    }
+}
+
+
+// Скрывает строки региона header. Скрытые блоки не раскладываются и не рисуются документом.
+void Editor::fold(const QTextBlock &header)
+{
+    QTextBlock last = Folding::regionEnd(header, foldingDelimiters());
+
+    if (last == header)
+    {
+        return;
+    }
+
+    for (QTextBlock block = header.next(); block.isValid(); block = block.next())
+    {
+        block.setVisible(false);
+
+        if (block == last)
+        {
+            break;
+        }
+    }
+
+    foldedHeaders.append(QTextCursor(header));
+    blocksVisibilityChanged(header.next().position(), last.position() + last.length());
+
+    // Курсор не должен оставаться в скрытой строке
+    if (!textCursor().block().isVisible())
+    {
+        QTextCursor cursor(header);
+        cursor.movePosition(QTextCursor::EndOfBlock);
+        setTextCursor(cursor);
+    }
+}
+
+
+/* Показывает скрытые строки после header. Вложенные регионы, свернутые ранее,
+   остаются свернутыми: их строки пропускаются.
+ */
+void Editor::unfold(const QTextBlock &header)
+{
+    QSet<int> nestedHeaders;
+
+    for (int i = foldedHeaders.size() - 1; i >= 0; i--)
+    {
+        QTextBlock foldedHeader = foldedHeaders.at(i).block();
+
+        if (foldedHeader == header)
+        {
+            foldedHeaders.remove(i);
+        }
+        else
+        {
+            nestedHeaders.insert(foldedHeader.blockNumber());
+        }
+    }
+
+    Folding::Delimiters delimiters = foldingDelimiters();
+    QTextBlock last = header;
+
+    for (QTextBlock block = header.next(); block.isValid() && !block.isVisible(); block = block.next())
+    {
+        block.setVisible(true);
+        last = block;
+
+        if (nestedHeaders.contains(block.blockNumber()))
+        {
+            block = Folding::regionEnd(block, delimiters);
+            last = block;
+        }
+    }
+
+    blocksVisibilityChanged(header.position(), last.position() + last.length());
+}
+
+
+// Разворачивает все регионы, скрывающие block (в том числе вложенные друг в друга).
+void Editor::revealBlock(const QTextBlock &block)
+{
+    if (primary)
+    {
+        primary->revealBlock(block);
+        return;
+    }
+
+    while (!block.isVisible())
+    {
+        QTextBlock header = block.previous();
+
+        while (header.isValid() && !header.isVisible())
+        {
+            header = header.previous();
+        }
+
+        if (!header.isValid())
+        {
+            unfoldAll();
+            return;
+        }
+
+        unfold(header);
+    }
+}
+
+
+// Сворачивает все регионы документа за один проход по блокам.
+void Editor::foldAll()
+{
+    if (primary)
+    {
+        primary->foldAll();
+        return;
+    }
+
+    QVector<QTextBlock> headers = Folding::hideAllRegions(document(), foldingDelimiters());
+
+    foldedHeaders.clear();
+    foldedHeaders.reserve(headers.size());
+
+    for (const QTextBlock &header : headers)
+    {
+        foldedHeaders.append(QTextCursor(header));
+    }
+
+    blocksVisibilityChanged(0, document()->characterCount());
+
+    // Курсор переносится на заголовок скрывшего его региона
+    leaveHiddenBlock();
+}
+
+
+// Показывает все строки документа.
+void Editor::unfoldAll()
+{
+    if (primary)
+    {
+        primary->unfoldAll();
+        return;
+    }
+
+    for (QTextBlock block = document()->begin(); block.isValid(); block = block.next())
+    {
+        block.setVisible(true);
+    }
+
+    foldedHeaders.clear();
+    blocksVisibilityChanged(0, document()->characterCount());
+}
+
+
+/* Просит документ заново разложить диапазон, в котором изменилась видимость блоков.
+   markContentsDirty не выдает contentsChange, поэтому индекс и миникарта не затрагиваются.
+ */
+void Editor::blocksVisibilityChanged(int from, int to)
+{
+    document()->markContentsDirty(from, to - from);
+    viewport()->update();
+
+    for (Editor *view : views)
+    {
+        view->viewport()->update();
+        view->leaveHiddenBlock();
+    }
+    lineNumberArea->update();
+}
+
+
+// Переносит курсор со строки, скрытой сворачиванием, на заголовок скрывшего ее региона.
+void Editor::leaveHiddenBlock()
+{
+    QTextBlock cursorBlock = textCursor().block();
+
+    while (!cursorBlock.isVisible() && cursorBlock.previous().isValid())
+    {
+        cursorBlock = cursorBlock.previous();
+    }
+
+    if (cursorBlock != textCursor().block())
+    {
+        QTextCursor cursor(cursorBlock);
+        cursor.movePosition(QTextCursor::EndOfBlock);
+        setTextCursor(cursor);
+    }
+}
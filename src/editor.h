@@ -4,12 +4,31 @@
 #include "gotodialog.h"
 #include "searchhistory.h"
 #include "documentmetrics.h"
+#include "memoryusage.h"
+#include "hibernatedtab.h"
 #include "language.h"
 #include "code_highlighters/highlighter.h"
 #include "settings.h"
+#include "clipboardmimedata.h"
+#include "identifierindex.h"
+#include "reindenter.h"
+#include "gutterrenderer.h"
+#include "minimap.h"
+#include "folding.h"
+#include "latencymonitor.h"
+#include "tracer.h"
+#include "recoveryjournal.h"
+#include "filewatcher.h"
+#include "linediff.h"
 #include <QPlainTextEdit>
 #include <QFont>
 #include <QMessageBox>
+#include <QCompleter>
+#include <QStringListModel>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QFutureWatcher>
+#include <QMenu>
 
 
 using namespace ProgrammingLanguage;
@@ -20,6 +39,7 @@ class Editor : public QPlainTextEdit
 
 public:
     Editor(QWidget *parent = nullptr);
+    Editor(Editor *primary, QWidget *parent = nullptr);
     ~Editor() override;
     void reset();
 
@@ -30,7 +50,32 @@ public:
     inline Language getProgrammingLanguage() const { return programmingLanguage; }
     inline bool isUntitled() const { return fileIsUntitled; }
 
+    // Разделенная вкладка: дополнительные виды показывают документ основного редактора
+    inline bool isSplit() const { return primary || !views.isEmpty(); }
+    inline Editor *primaryEditor() { return primary ? primary : this; }
+    inline const QVector<Editor*> &splitViews() const { return views; }
+
     inline DocumentMetrics getDocumentMetrics() const { return metrics; }
+    inline const IdentifierIndex &getIdentifierIndex() const { return identifierIndex; }
+    inline MemoryUsage getMemoryUsage() const { return memory; }
+    MemoryUsage measureMemoryUsage();
+    void releaseCaches(int undoStepsToKeep);
+
+    bool hibernate();
+    bool rehydrate();
+    void deferLoading(const QString &filePath, int cursorPosition);
+    inline void prefetch() { if (hibernated) hibernated->prefetch(); }
+    void loadInBackground();
+    void journalRecoveredText();
+
+    // Изменения файла вкладки на диске (см. FileWatcher)
+    void syncDiskState();
+    inline bool changedOnDisk() const { return primary ? primary->changedOnDisk() : !fileIsUntitled && disk.differsFrom(currentFilePath); }
+    void reloadFromDisk(bool discardChanges = false);
+    inline int sessionCursorPosition() const { return hibernated ? hibernated->cursorPosition : textCursor().position(); }
+    inline bool isHibernated() const { return hibernated != nullptr; }
+    inline bool hasUndoHistory() const { return document()->availableUndoSteps() + document()->availableRedoSteps() > 0; }
+    qint64 idleMilliseconds() const;
     QFont getFont() { return font; }
     void setFont(QFont newFont, QFont::StyleHint styleHint, bool fixedPitch, int tabStopWidth);
 
@@ -41,45 +86,96 @@ public:
     void toggleAutoIndent(bool autoIndent);
     bool textIsAutoIndented() const { return autoIndentEnabled; }
     void toggleWrapMode(bool wrap);
-    bool textIsWrapped() const { return lineWrapMode == LineWrapMode::WidgetWidth; }
+    bool textIsWrapped() const { return wrapPending ? pendingWrap : lineWrapMode == LineWrapMode::WidgetWidth; }
+
+    // Шрифт и перенос для фоновой вкладки применяются при ее показе или в простое (см. TabbedEditor)
+    void deferFont(const QFont &newFont);
+    void deferWrapMode(bool wrap);
+    inline bool hasPendingFormat() const { return fontPending || wrapPending; }
+    void applyPendingFormat();
+    void reindentDocument();
+    void convertIndentation(bool useSpaces);
+
+    void toggleFold(QTextBlock header);
+    inline void toggleFoldAtCursor() { toggleFold(textCursor().block()); }
+    void foldAll();
+    void unfoldAll();
 
     inline bool redoAvailable() const { return canRedo; }
     inline bool undoAvailable() const { return canUndo; }
 
     void lineNumberAreaPaintEvent(QPaintEvent *event);
+    void lineNumberAreaMousePressEvent(QMouseEvent *event);
     int getLineNumberAreaWidth();
+    inline int firstVisibleLine() const { return firstVisibleBlock().blockNumber(); }
+    inline int visibleLineCount() const { return viewport()->height() / qMax(1, fontMetrics().height()); }
 
     void setLineWrapMode(LineWrapMode lineWrapMode);
+    void preserveClipboardSnapshot(int from, int to);
+    inline void preserveClipboardSnapshot() { preserveClipboardSnapshot(0, document()->characterCount()); }
+
+    // Общие с пакетным режимом (batch.h) операции над документом без виджета
+    static Highlighter *generateHighlighterFor(Language language, QTextDocument *document);
+    static QTextDocument::FindFlags getSearchOptionsFromFlags(bool caseSensitive, bool wholeWords);
+    static int replaceAllIn(QTextDocument *document, const QString &what, const QString &with,
+                            QTextDocument::FindFlags searchOptions);
 
     const static int DEFAULT_FONT_SIZE = 10;
     const static int NUM_CHARS_FOR_TAB = 5;
+    const static int LAZY_CLIPBOARD_THRESHOLD = 1 << 20;
+    const static int MAX_COMPLETIONS = 50;
+    const static int STATUS_UPDATE_INTERVAL_MS = 16;
+    const static int JOURNAL_COMPACT_IDLE_MS = 2000;
+
+    // Оценки накладных расходов Qt для measureMemoryUsage, в байтах
+    const static int BLOCK_BYTES = 96;
+    const static int GLYPH_BYTES_PER_CHAR = 24;
+    const static int LINE_BYTES = 64;
+    const static int FORMAT_BYTES_PER_CHAR = 4;
+    const static int UNDO_COMMAND_BYTES = 64;
 
     bool autoIndentEnabled = true;
     LineWrapMode lineWrapMode = Editor::LineWrapMode::NoWrap;
 
 protected:
     void resizeEvent(QResizeEvent *event) override;
+    void paintEvent(QPaintEvent *event) override;
+    void changeEvent(QEvent *event) override;
+    void showEvent(QShowEvent *event) override;
+    void hideEvent(QHideEvent *event) override;
     bool eventFilter(QObject* obj, QEvent* event) override;
+    void keyPressEvent(QKeyEvent *event) override;
+    QMimeData *createMimeDataFromSelection() const override;
+    void insertFromMimeData(const QMimeData *source) override;
+    void dropEvent(QDropEvent *event) override;
+    void inputMethodEvent(QInputMethodEvent *event) override;
+    void contextMenuEvent(QContextMenuEvent *event) override;
 
 signals:
     void findResultReady(QString message);
     void gotoResultReady(QString message);
-    void wordCountChanged(int words);
-    void charCountChanged(int chars);
-    void lineCountChanged(int current, int total);
-    void columnCountChanged(int col);
-    void fileContentsChanged();
+    void metricsChanged(DocumentMetrics metrics);
+    void titleStateChanged();
+    void loadFailed();
 
 public slots:
     bool find(QString query, bool caseSensitive, bool wholeWords);
     void replace(QString what, QString with, bool caseSensitive, bool wholeWords);
     void replaceAll(QString what, QString with, bool caseSensitive, bool wholeWords);
     void goTo(int line);
+    void cut();
+    void undo();
+    void redo();
 
 private slots:
     void on_textChanged();
     void updateLineNumberAreaWidth();
     void on_cursorPositionChanged();
+    void on_contentsChange(int position, int charsRemoved, int charsAdded);
+    void emitMetrics();
+    void on_modificationChanged(bool modified);
+    void compactJournal();
+    void insertCompletion(QString completion);
 
     void redrawLineNumberArea(const QRect &rectToBeRedrawn, int numPixelsScrolledVertically);
 
@@ -87,29 +183,55 @@ private slots:
     void setRedoAvailable(bool available) { canRedo = available; }
 
 private:
-    Highlighter *generateHighlighterFor(Language language);
+    // Бенчмарки (../benchmarks) и тесты (../tests) обращаются к закрытым операциям редактора напрямую
+    friend class EditorBenchmark;
+    friend class EditorTest;
+
+    void initialize();
     QString getFileNameFromPath();
-    QTextDocument::FindFlags getSearchOptionsFromFlags(bool caseSensitive, bool wholeWords);
     bool handleEnterKeyPress();
     bool handleTabKeyPress();
     void moveCursorTo(int positionInText);
+    void preserveClipboardSnapshot(QKeyEvent *keyEvent);
+    QMenu *createContextMenu(const QPoint &position);
+
+    QString identifierPrefixUnderCursor() const;
+    void updateCompletionPopup(bool forced);
 
     void highlightCurrentLine();
+    QRect currentLineRect() const;
     void updateWordCount();
     void updateCharCount();
     void updateColumnCount();
     void updateLineCount();
+    void scheduleMetrics();
 
     int indentationLevelOfCurrentLine();
     void moveCursorToStartOfCurrentLine();
     void insertTabs(int numTabs);
     void indentSelection(QTextDocumentFragment selection);
+    QVector<QString> documentLines() const;
+    void applyLineEdits(const QVector<Reindenter::LineEdit> &edits);
+    bool appendFromDisk();
+    void applyHunks(const QVector<LineDiff::Hunk> &hunks);
+    bool usesNestingDelimiters() const;
+
+    Folding::Delimiters foldingDelimiters() const;
+    bool isFolded(const QTextBlock &block) const;
+    void fold(const QTextBlock &header);
+    void unfold(const QTextBlock &header);
+    void revealBlock(const QTextBlock &block);
+    void blocksVisibilityChanged(int from, int to);
+    void leaveHiddenBlock();
+
+    void noteLaidOut(int from, int to);
+    void updateDocumentMemory();
 
     void writeSettings();
     void readSettings();
 
-    Language programmingLanguage;
-    Highlighter *syntaxHighlighter;
+    Language programmingLanguage = Language::None;
+    Highlighter *syntaxHighlighter = nullptr;
     const static QColor LINE_COLOR;
 
     DocumentMetrics metrics;
@@ -119,12 +241,85 @@ private:
     QFont font;
     QTextCharFormat defaultCharFormat;
     SearchHistory searchHistory;
+    IdentifierIndex identifierIndex;
+    QCompleter *completer;
+    QStringListModel *completionModel;
+
+    void refreshGutterMetrics();
+    void layoutSideWidgets();
 
     QWidget *lineNumberArea;
+    Minimap *minimap = nullptr;
     const int lineNumberAreaPadding = 30;
+    const int foldMarkerWidth = 14;
+    GutterRenderer gutterRenderer;
+    int lineNumberDigits = 0;
+
+    // Полоса текущей строки рисуется в paintEvent; здесь хранится последний нарисованный прямоугольник
+    QRect highlightedLineRect;
+    QTimer *metricsTimer;
+    bool textMetricsStale = false;
 
     bool canRedo = false;
     bool canUndo = false;
+    bool eagerClipboard = false;
+
+    // Заголовки свернутых регионов. Документ сам сдвигает позиции курсоров при правках,
+    // поэтому состояние сворачивания переживает редактирование текста вокруг регионов
+    QVector<QTextCursor> foldedHeaders;
+
+    // Последний замер памяти и накопленный объем правок в стеках отмены и повтора
+    MemoryUsage memory;
+    qint64 undoBytes = 0;
+
+    // Позиции, которые отрисовывались после последнего сброса раскладки (оценка сверху
+    // для разложенных блоков; пустой диапазон, если laidOutTo <= laidOutFrom)
+    int laidOutFrom = 0;
+    int laidOutTo = 0;
+
+    // releaseCaches помечает весь документ измененным; такие contentsChange не являются правками
+    bool releasingCaches = false;
+    // Подсветчик отключен от документа до следующего показа вкладки
+    bool formatsReleased = false;
+
+    // Отложенные deferFont/deferWrapMode значения, которые еще не разложены
+    QFont pendingFont;
+    bool fontPending = false;
+    bool pendingWrap = false;
+    bool wrapPending = false;
+
+    // Основной редактор, если это дополнительный вид разделенной вкладки, и виды этого редактора
+    Editor *primary = nullptr;
+    QVector<Editor*> views;
+
+    // Журнал несохраненных правок для восстановления после сбоя (только у основного редактора)
+    RecoveryJournal *journal = nullptr;
+    QTimer *journalCompactionTimer = nullptr;
+    // hibernate и rehydrate заменяют текст через setPlainText, который снимает признак изменения;
+    // это не сохранение, и журнал должен пережить выгрузку вкладки
+    bool keepingJournal = false;
+
+    // Файл вкладки на диске и его перечитывание: разность с документом считается в пуле потоков
+    struct DiskReload
+    {
+        bool ok = false;
+        DiskState disk;
+        QVector<LineDiff::Hunk> hunks;
+    };
+
+    DiskState disk;
+    QFutureWatcher<DiskReload> *diskReload = nullptr;
+    bool diskReloadQueued = false;
+    bool reloadingFromDisk = false;
+
+    // Текст и состояние выгруженной вкладки; nullptr, пока вкладка в памяти
+    HibernatedTab *hibernated = nullptr;
+    // С какого момента вкладка не показывается (для выгрузки по простою)
+    QElapsedTimer hiddenSince;
+
+    // Ленивые данные буфера обмена, которые еще ссылаются на этот документ (только у основного
+    // редактора: сюда попадают и данные, скопированные в дополнительных видах)
+    mutable QVector<QPointer<ClipboardMimeData>> pendingClipboardData;
 
     Settings *settings = Settings::instance();
 
@@ -0,0 +1,118 @@
+#include "filewatcher.h"
+#include "editor.h"
+#include <QCoreApplication>
+#include <QFile>
+#include <QFileInfo>
+
+
+// Снимает размер, время изменения и последние байты файла filePath.
+DiskState DiskState::read(const QString &filePath)
+{
+    DiskState state;
+    QFileInfo info(filePath);
+    QFile file(filePath);
+
+    if (!info.exists() || !file.open(QIODevice::ReadOnly))
+    {
+        return state;
+    }
+
+    state.size = info.size();
+    state.modified = info.lastModified();
+
+    qint64 tailStart = qMax(qint64(0), state.size - TAIL_BYTES);
+    if (file.seek(tailStart))
+    {
+        state.tail = file.read(state.size - tailStart);
+        state.size = tailStart + state.tail.size();
+    }
+    return state;
+}
+
+
+// Возвращает true, если файл filePath существует и его размер или время изменения другие.
+bool DiskState::differsFrom(const QString &filePath) const
+{
+    QFileInfo info(filePath);
+    return info.exists() && (info.size() != size || info.lastModified() != modified);
+}
+
+
+FileWatcher::FileWatcher()
+{
+    watcher = new QFileSystemWatcher(QCoreApplication::instance());
+    connect(watcher, SIGNAL(fileChanged(QString)), this, SLOT(on_fileChanged(QString)));
+}
+
+
+// Возвращает синглтон FileWatcher.
+FileWatcher *FileWatcher::instance()
+{
+    static FileWatcher singleton;
+    return &singleton;
+}
+
+
+/* Следит за файлом filePath вкладки tab вместо прежнего. Повторный вызов с тем же путем
+   снова добавляет путь, если слежение за ним было потеряно (файл еще не был создан или был заменен).
+ */
+void FileWatcher::watch(Editor *tab, const QString &filePath)
+{
+    QString path = filePath.isEmpty() ? QString() : QFileInfo(filePath).absoluteFilePath();
+
+    if (watchedPaths.value(tab) != path)
+    {
+        unwatch(tab);
+    }
+
+    if (path.isEmpty())
+    {
+        return;
+    }
+
+    watchedPaths.insert(tab, path);
+    if (!watcher->files().contains(path) && QFileInfo::exists(path))
+    {
+        watcher->addPath(path);
+    }
+}
+
+
+// Перестает следить за файлом вкладки, если он не открыт в других вкладках.
+void FileWatcher::unwatch(Editor *tab)
+{
+    QString path = watchedPaths.take(tab);
+
+    if (!path.isEmpty() && watchedPaths.key(path) == nullptr)
+    {
+        watcher->removePath(path);
+    }
+}
+
+
+void FileWatcher::on_fileChanged(const QString &filePath)
+{
+    // Сохранение через переименование заменяет файл, и QFileSystemWatcher перестает за ним следить
+    if (!watcher->files().contains(filePath) && QFileInfo::exists(filePath))
+    {
+        watcher->addPath(filePath);
+    }
+
+    for (Editor *tab : watchedPaths.keys(filePath))
+    {
+        // Собственное сохранение вкладки и изменение только атрибутов файла не считаются
+        if (!tab->changedOnDisk())
+        {
+            continue;
+        }
+
+        if (tab->isUnsaved())
+        {
+            emit changedWhileUnsaved(tab);
+        }
+        else
+        {
+            tab->reloadFromDisk();
+        }
+    }
+}
@@ -0,0 +1,65 @@
+#ifndef FILEWATCHER_H
+#define FILEWATCHER_H
+#include <QObject>
+#include <QFileSystemWatcher>
+#include <QByteArray>
+#include <QDateTime>
+#include <QHash>
+#include <QSharedPointer>
+#include <QString>
+#include <QTextDecoder>
+
+class Editor;
+
+
+/* Файл вкладки на диске на момент последнего чтения или сохранения. По размеру и времени
+   изменения видно, что файл изменился; по последним TAIL_BYTES байтам - что он был только дописан.
+ */
+struct DiskState
+{
+    qint64 size = -1;                        // -1 - состояние неизвестно
+    QDateTime modified;
+    QByteArray tail;
+
+    // Дописанные байты декодируются по мере поступления; декодер хранит оборванный многобайтовый символ
+    QSharedPointer<QTextDecoder> decoder;
+
+    static DiskState read(const QString &filePath);
+    bool differsFrom(const QString &filePath) const;
+
+    const static int TAIL_BYTES = 4096;
+};
+
+
+/* Слежение за файлами открытых вкладок. Один QFileSystemWatcher (inotify в Linux) на все
+   вкладки: вкладки с одним файлом делят его путь. Когда файл меняется на диске, вкладка без
+   несохраненных правок перечитывает его сама (Editor::reloadFromDisk), а о вкладке с правками
+   сообщается через changedWhileUnsaved, чтобы спросить пользователя.
+ */
+class FileWatcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    static FileWatcher *instance();
+    void watch(Editor *tab, const QString &filePath);
+    void unwatch(Editor *tab);
+
+signals:
+    void changedWhileUnsaved(Editor *tab);
+
+private slots:
+    void on_fileChanged(const QString &filePath);
+
+// Singleton
+private:
+    FileWatcher();
+    FileWatcher(const FileWatcher& other);
+    FileWatcher &operator=(const FileWatcher& other);
+
+    // Живет в потоке GUI и удаляется вместе с приложением
+    QFileSystemWatcher *watcher;
+    QHash<Editor*, QString> watchedPaths;
+};
+
+#endif // FILEWATCHER_H
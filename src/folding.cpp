@@ -0,0 +1,292 @@
+#include "folding.h"
+#include "reindenter.h"
+
+
+namespace
+{
+    // Ширина отступа строки в колонках или -1, если строка пустая (только пробельные символы).
+    int indentationWidth(const QString &text, int tabWidth)
+    {
+        int width = 0;
+        for (QChar character : text)
+        {
+            if (character == ' ')
+            {
+                width++;
+            }
+            else if (character == '\t')
+            {
+                width = (width / tabWidth + 1) * tabWidth;
+            }
+            else
+            {
+                return width;
+            }
+        }
+        return -1;
+    }
+
+
+    /* Количество открывающих разделителей строки, оставшихся без пары в этой же строке.
+       Разделители в строковых литералах и комментариях не считаются (см. Reindenter::scanCode).
+     */
+    int unmatchedOpenings(const QString &text, QChar open, QChar close, bool &inComment)
+    {
+        int openings = 0;
+        Reindenter::scanCode(text, inComment, [&](int, QChar character) {
+            if (character == open)
+            {
+                openings++;
+            }
+            else if (character == close && openings > 0)
+            {
+                openings--;
+            }
+        });
+        return openings;
+    }
+
+
+    /* Сдвигает глубину depth по разделителям строки, пока она не станет нулевой.
+       Возвращает false, если строка закрыла регион.
+     */
+    bool staysOpen(const QString &text, const Folding::Delimiters &delimiters, bool &inComment, int &depth)
+    {
+        Reindenter::scanCode(text, inComment, [&](int, QChar character) {
+            if (depth == 0)
+            {
+                return;
+            }
+
+            if (character == delimiters.open)
+            {
+                depth++;
+            }
+            else if (character == delimiters.close)
+            {
+                depth--;
+            }
+        });
+        return depth > 0;
+    }
+
+
+    // Следующий непустой блок после block (или невалидный блок).
+    QTextBlock nextNonBlank(QTextBlock block, int tabWidth, int &indentation)
+    {
+        for (block = block.next(); block.isValid(); block = block.next())
+        {
+            indentation = indentationWidth(block.text(), tabWidth);
+            if (indentation >= 0)
+            {
+                break;
+            }
+        }
+        return block;
+    }
+
+
+    QTextBlock braceRegionEnd(const QTextBlock &header, const Folding::Delimiters &delimiters)
+    {
+        bool inComment = false;
+        int depth = unmatchedOpenings(header.text(), delimiters.open, delimiters.close, inComment);
+        QTextBlock last = header;
+
+        for (QTextBlock block = header.next(); block.isValid() && depth > 0; block = block.next())
+        {
+            // Строка с парной закрывающей скобкой остается видимой
+            if (staysOpen(block.text(), delimiters, inComment, depth))
+            {
+                last = block;
+            }
+        }
+
+        return last;
+    }
+
+
+    QTextBlock indentRegionEnd(const QTextBlock &header, const Folding::Delimiters &delimiters)
+    {
+        int headerIndentation = indentationWidth(header.text(), delimiters.tabWidth);
+        QTextBlock last = header;
+
+        if (headerIndentation < 0)
+        {
+            return last;
+        }
+
+        int indentation = 0;
+        for (QTextBlock block = nextNonBlank(header, delimiters.tabWidth, indentation);
+             block.isValid() && indentation > headerIndentation;
+             block = nextNonBlank(block, delimiters.tabWidth, indentation))
+        {
+            last = block;
+        }
+
+        return last;
+    }
+
+
+    // Один проход со стеком открытых скобок. Строка скрыта, если ее переживает скобка из предыдущей строки.
+    QVector<QTextBlock> hideBraceRegions(QTextDocument *document, const Folding::Delimiters &delimiters)
+    {
+        QVector<QTextBlock> headers;
+        QVector<QTextBlock> openings;
+
+        auto addHeader = [&headers](const QTextBlock &header, int closingNumber) {
+            bool regionIsEmpty = closingNumber - header.blockNumber() < 2;
+            if (!regionIsEmpty && (headers.isEmpty() || headers.last() != header))
+            {
+                headers.append(header);
+            }
+        };
+
+        bool inComment = false;
+        for (QTextBlock block = document->begin(); block.isValid(); block = block.next())
+        {
+            int lowestDepth = openings.size();
+
+            Reindenter::scanCode(block.text(), inComment, [&](int, QChar character) {
+                if (character == delimiters.open)
+                {
+                    openings.append(block);
+                }
+                else if (character == delimiters.close && !openings.isEmpty())
+                {
+                    addHeader(openings.takeLast(), block.blockNumber());
+                    lowestDepth = qMin(lowestDepth, openings.size());
+                }
+            });
+
+            block.setVisible(lowestDepth == 0);
+        }
+
+        // Незакрытые регионы продолжаются до конца документа
+        for (const QTextBlock &header : openings)
+        {
+            addHeader(header, document->blockCount());
+        }
+
+        return headers;
+    }
+
+
+    /* Один проход со стеком уровней отступа. Пустые строки откладываются до следующей непустой:
+       они скрыты, только если эта строка тоже находится внутри региона.
+     */
+    QVector<QTextBlock> hideIndentRegions(QTextDocument *document, const Folding::Delimiters &delimiters)
+    {
+        struct Level
+        {
+            int indentation;
+            QTextBlock block;
+        };
+
+        QVector<QTextBlock> headers;
+        QVector<Level> levels;
+        QVector<QTextBlock> blanks;
+        QTextBlock lastNonBlank;
+
+        auto closeLevel = [&]() {
+            Level level = levels.takeLast();
+            if (level.block != lastNonBlank)
+            {
+                headers.append(level.block);
+            }
+        };
+
+        for (QTextBlock block = document->begin(); block.isValid(); block = block.next())
+        {
+            int indentation = indentationWidth(block.text(), delimiters.tabWidth);
+
+            if (indentation < 0)
+            {
+                blanks.append(block);
+                continue;
+            }
+
+            while (!levels.isEmpty() && levels.last().indentation >= indentation)
+            {
+                closeLevel();
+            }
+
+            bool hidden = !levels.isEmpty();
+            for (QTextBlock &blank : blanks)
+            {
+                blank.setVisible(!hidden);
+            }
+            blanks.clear();
+
+            block.setVisible(!hidden);
+            levels.append({indentation, block});
+            lastNonBlank = block;
+        }
+
+        while (!levels.isEmpty())
+        {
+            closeLevel();
+        }
+
+        for (QTextBlock &blank : blanks)
+        {
+            blank.setVisible(true);
+        }
+
+        return headers;
+    }
+}
+
+
+/* Возвращает true, если со строки block начинается непустой регион сворачивания.
+   Вызывается для каждой видимой строки при отрисовке поля, поэтому смотрит только
+   на следующую строку, а не ищет конец региона.
+ */
+bool Folding::startsRegion(const QTextBlock &block, const Delimiters &delimiters)
+{
+    if (delimiters.close.isNull())
+    {
+        int headerIndentation = indentationWidth(block.text(), delimiters.tabWidth);
+        int indentation = 0;
+        return headerIndentation >= 0 && nextNonBlank(block, delimiters.tabWidth, indentation).isValid() &&
+               indentation > headerIndentation;
+    }
+
+    bool inComment = false;
+    int depth = unmatchedOpenings(block.text(), delimiters.open, delimiters.close, inComment);
+    QTextBlock next = block.next();
+
+    if (depth == 0 || !next.isValid())
+    {
+        return false;
+    }
+
+    // Регион непуст, если следующая строка не закрывает его сама
+    return staysOpen(next.text(), delimiters, inComment, depth);
+}
+
+
+// Возвращает последний блок региона, начинающегося с header, или сам header, если регион пуст.
+QTextBlock Folding::regionEnd(const QTextBlock &header, const Delimiters &delimiters)
+{
+    if (delimiters.close.isNull())
+    {
+        return indentRegionEnd(header, delimiters);
+    }
+
+    return braceRegionEnd(header, delimiters);
+}
+
+
+/* Сворачивает все регионы документа за один проход: каждый блок получает итоговую видимость
+   ровно один раз, поэтому вложенные регионы не обходятся повторно. Возвращает заголовки всех
+   регионов (включая вложенные), чтобы при разворачивании внешнего вложенные оставались свернутыми.
+ */
+QVector<QTextBlock> Folding::hideAllRegions(QTextDocument *document, const Delimiters &delimiters)
+{
+    if (delimiters.close.isNull())
+    {
+        return hideIndentRegions(document, delimiters);
+    }
+
+    return hideBraceRegions(document, delimiters);
+}
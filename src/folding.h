@@ -0,0 +1,30 @@
+#ifndef FOLDING_H
+#define FOLDING_H
+#include <QTextDocument>
+#include <QTextBlock>
+#include <QVector>
+#include <QChar>
+
+
+/* Регионы сворачивания кода. Для языков с закрывающим разделителем блока (C, C++, Java)
+   регион - строки между строкой с незакрытой открывающей скобкой и строкой с парной
+   закрывающей (сама она остается видимой); скобки в строковых литералах и комментариях
+   не считаются. Строка заголовка считается начинающейся вне комментария. Без закрывающего разделителя (Python, обычный текст)
+   регион - следующие за строкой более глубоко отступленные строки.
+   Свернутые строки помечаются невидимыми блоками, поэтому документ не раскладывает и не рисует их.
+ */
+namespace Folding
+{
+    struct Delimiters
+    {
+        QChar open;                  // QChar() - регионы определяются по отступам
+        QChar close;
+        int tabWidth = 4;
+    };
+
+    bool startsRegion(const QTextBlock &block, const Delimiters &delimiters);
+    QTextBlock regionEnd(const QTextBlock &header, const Delimiters &delimiters);
+    QVector<QTextBlock> hideAllRegions(QTextDocument *document, const Delimiters &delimiters);
+}
+
+#endif // FOLDING_H
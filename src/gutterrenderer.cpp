@@ -0,0 +1,67 @@
+#include "gutterrenderer.h"
+#include <QFontMetrics>
+
+
+/* Подготавливает глифы цифр для заданного шрифта. Возвращает true, если шрифт изменился
+   и кэш был перестроен (например, после смены шрифта или масштабирования).
+ */
+bool GutterRenderer::setFont(const QFont &font)
+{
+    if (initialized && font == this->font)
+    {
+        return false;
+    }
+
+    this->font = font;
+    initialized = true;
+
+    QFontMetrics metrics(font);
+    lineHeight = metrics.height();
+    maxDigitWidth = 0;
+
+    for (int digit = 0; digit < 10; digit++)
+    {
+        QChar character('0' + digit);
+        digits[digit] = QStaticText(QString(character));
+        digits[digit].setTextFormat(Qt::PlainText);
+        digits[digit].prepare(QTransform(), font);
+        digitAdvances[digit] = metrics.horizontalAdvance(character);
+        maxDigitWidth = qMax(maxDigitWidth, digitAdvances[digit]);
+    }
+
+    return true;
+}
+
+
+/* Рисует number так, чтобы его правый край приходился на right. Цифры рисуются справа налево,
+   поэтому выравнивание совпадает с drawText(..., Qt::AlignRight, ...).
+   Шрифт и перо painter должны быть установлены вызывающим кодом один раз на всю перерисовку.
+ */
+void GutterRenderer::drawNumber(QPainter &painter, int number, int right, int top) const
+{
+    int x = right;
+
+    do
+    {
+        int digit = number % 10;
+        x -= digitAdvances[digit];
+        painter.drawStaticText(x, top, digits[digit]);
+        number /= 10;
+    }
+    while (number > 0);
+}
+
+
+// Количество десятичных цифр в number (для number >= 0).
+int GutterRenderer::numDigits(int number)
+{
+    int count = 1;
+
+    while (number >= 10)
+    {
+        number /= 10;
+        count++;
+    }
+
+    return count;
+}
@@ -0,0 +1,35 @@
+#ifndef GUTTERRENDERER_H
+#define GUTTERRENDERER_H
+#include <QFont>
+#include <QPainter>
+#include <QStaticText>
+
+
+/* Отрисовка номеров строк из заранее подготовленных глифов цифр. QStaticText для каждой
+   цифры строится один раз для шрифта (и масштаба), поэтому при прокрутке номера строк
+   рисуются без QString::number и повторной раскладки текста.
+ */
+class GutterRenderer
+{
+public:
+    GutterRenderer(){}
+
+    bool setFont(const QFont &font);
+    inline QFont getFont() const { return font; }
+    inline int getLineHeight() const { return lineHeight; }
+    inline int getMaxDigitWidth() const { return maxDigitWidth; }
+
+    void drawNumber(QPainter &painter, int number, int right, int top) const;
+
+    static int numDigits(int number);
+
+private:
+    QFont font;
+    QStaticText digits[10];
+    int digitAdvances[10] = {};
+    int maxDigitWidth = 0;
+    int lineHeight = 0;
+    bool initialized = false;
+};
+
+#endif // GUTTERRENDERER_H
@@ -0,0 +1,117 @@
+#include "hibernatedtab.h"
+#include <QDir>
+#include <QFile>
+#include <QTextStream>
+#include <QtConcurrent>
+
+
+namespace
+{
+    // Читает файл так же, как MainWindow::on_actionOpen_triggered; first - удалось ли открыть файл
+    QPair<bool, QString> readFile(const QString &filePath)
+    {
+        QFile file(filePath);
+        if (!file.open(QIODevice::ReadOnly | QFile::Text))
+        {
+            return qMakePair(false, QString());
+        }
+
+        QTextStream in(&file);
+        return qMakePair(true, in.readAll());
+    }
+}
+
+
+HibernatedTab::~HibernatedTab()
+{
+    delete file;
+}
+
+
+/* Сжимает текст быстрым уровнем zlib. Большой блок уходит во временный файл; если файл
+   записать не удалось, блок остается в памяти.
+ */
+void HibernatedTab::store(const QString &text)
+{
+    blob = qCompress(text.toUtf8(), COMPRESSION_LEVEL);
+
+    if (blob.size() <= MAX_IN_MEMORY_BYTES)
+    {
+        return;
+    }
+
+    file = new QTemporaryFile(QDir(QDir::tempPath()).filePath("textr-hibernated-XXXXXX"));
+
+    if (file->open() && file->write(blob) == blob.size() && file->flush())
+    {
+        blob.clear();
+        blob.squeeze();
+    }
+    else
+    {
+        delete file;
+        file = nullptr;
+    }
+}
+
+
+/* Начинает чтение файла вкладки из сессии в пуле потоков, чтобы load не ждал диска.
+   Возвращает чтение (повторный вызов - то же самое); для вкладки без файла - пустой QFuture.
+ */
+QFuture<QPair<bool, QString>> HibernatedTab::prefetch()
+{
+    if (!filePath.isEmpty() && !prefetchStarted)
+    {
+        prefetchStarted = true;
+        prefetched = QtConcurrent::run(readFile, filePath);
+    }
+
+    return prefetched;
+}
+
+
+/* Возвращает сохраненный текст. ok становится false, если файл вкладки из сессии
+   не удалось открыть.
+ */
+QString HibernatedTab::load(bool *ok)
+{
+    if (ok)
+    {
+        *ok = true;
+    }
+
+    if (!filePath.isEmpty())
+    {
+        QPair<bool, QString> contents = prefetchStarted ? prefetched.result() : readFile(filePath);
+        if (ok)
+        {
+            *ok = contents.first;
+        }
+        return contents.second;
+    }
+
+    if (file == nullptr)
+    {
+        return QString::fromUtf8(qUncompress(blob));
+    }
+
+    file->seek(0);
+    return QString::fromUtf8(qUncompress(file->readAll()));
+}
+
+
+/* Файл вкладки изменился на диске: сохраненный текст устарел, и при показе вкладка прочитает
+   файл заново. Курсор и прокрутка остаются, а rehydrate ограничивает их концом нового текста.
+ */
+void HibernatedTab::discardText(const QString &newFilePath)
+{
+    blob.clear();
+    blob.squeeze();
+    delete file;
+    file = nullptr;
+
+    filePath = newFilePath;
+    modified = false;
+    prefetched = QFuture<QPair<bool, QString>>();
+    prefetchStarted = false;
+}
@@ -0,0 +1,48 @@
+#ifndef HIBERNATEDTAB_H
+#define HIBERNATEDTAB_H
+#include <QByteArray>
+#include <QString>
+#include <QTemporaryFile>
+#include <QVector>
+#include <QFuture>
+#include <QPair>
+
+
+/* Состояние вкладки, выгруженной из памяти (см. Editor::hibernate). Текст хранится сжатым:
+   в памяти или, если сжатый блок больше MAX_IN_MEMORY_BYTES, во временном файле, который
+   удаляется вместе с объектом. Вкладка, восстановленная из сессии, еще не прочитана:
+   ее текст берется из filePath при первом показе или заранее, в пуле потоков (prefetch).
+ */
+class HibernatedTab
+{
+    Q_DISABLE_COPY(HibernatedTab)
+
+public:
+    HibernatedTab(){}
+    ~HibernatedTab();
+
+    void store(const QString &text);
+    QFuture<QPair<bool, QString>> prefetch();
+    QString load(bool *ok = nullptr);
+    void discardText(const QString &newFilePath);
+    inline qint64 memoryUsage() const { return blob.size(); }
+
+    QString filePath;                    // непусто, пока текст вкладки не прочитан с диска
+    int cursorAnchor = 0;
+    int cursorPosition = 0;
+    int verticalScroll = -1;             // -1 - прокрутить к курсору
+    int horizontalScroll = 0;
+    bool modified = false;
+    QVector<int> foldedHeaders;          // номера блоков в порядке сворачивания
+
+    const static int MAX_IN_MEMORY_BYTES = 4 << 20;
+    const static int COMPRESSION_LEVEL = 1;
+
+private:
+    QByteArray blob;
+    QTemporaryFile *file = nullptr;
+    QFuture<QPair<bool, QString>> prefetched;
+    bool prefetchStarted = false;
+};
+
+#endif // HIBERNATEDTAB_H
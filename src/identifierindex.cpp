@@ -0,0 +1,230 @@
+#include "identifierindex.h"
+#include <QTextBlockUserData>
+#include <QVector>
+#include <QPair>
+#include <algorithm>
+
+
+/* Идентификаторы одного блока. Строки разделяют данные с ключами карты частот,
+   поэтому список стоит лишь по одному указателю на вхождение.
+ */
+class IdentifierBlockData : public QTextBlockUserData
+{
+public:
+    IdentifierBlockData(IdentifierIndex *index) : index(index) {}
+
+    // Вызывается документом, когда блок удаляется или сливается с соседним
+    ~IdentifierBlockData() override
+    {
+        if (index == nullptr)
+        {
+            return;
+        }
+
+        for (const QString &identifier : identifiers)
+        {
+            index->remove(identifier);
+        }
+    }
+
+    IdentifierIndex *index;
+    QStringList identifiers;
+};
+
+
+/* Блоки документа переживают индекс (документ удаляется базовым классом редактора),
+   поэтому отвязываем их данные, чтобы деструкторы блоков не обращались к индексу.
+ */
+IdentifierIndex::~IdentifierIndex()
+{
+    if (document == nullptr)
+    {
+        return;
+    }
+
+    for (QTextBlock block = document->begin(); block.isValid(); block = block.next())
+    {
+        IdentifierBlockData *data = dynamic_cast<IdentifierBlockData*>(block.userData());
+
+        if (data)
+        {
+            data->index = nullptr;
+        }
+    }
+}
+
+
+// Привязывает индекс к документу и индексирует его текущее содержимое.
+void IdentifierIndex::attach(QTextDocument *document)
+{
+    this->document = document;
+    update(0, 0, document->characterCount());
+}
+
+
+/* Вызывается на каждый сигнал contentsChange документа. Переразбирает только блоки,
+   попадающие в измененный диапазон; удаленные блоки уже вычли свои идентификаторы.
+ */
+void IdentifierIndex::update(int position, int charsRemoved, int charsAdded)
+{
+    Q_UNUSED(charsRemoved)
+
+    if (document == nullptr)
+    {
+        return;
+    }
+
+    QTextBlock block = document->findBlock(position);
+    QTextBlock last = document->findBlock(position + charsAdded);
+
+    if (!last.isValid())
+    {
+        last = document->lastBlock();
+    }
+
+    while (block.isValid())
+    {
+        reindexBlock(block);
+
+        if (block == last)
+        {
+            break;
+        }
+
+        block = block.next();
+    }
+}
+
+
+/* Возвращает до maxResults идентификаторов, начинающихся с prefix (но не равных ему),
+   упорядоченных по убыванию частоты. Диапазон префикса находится за O(log n) через lowerBound.
+ */
+QStringList IdentifierIndex::complete(const QString &prefix, int maxResults) const
+{
+    QVector<QPair<int, QString>> matches;
+
+    for (auto it = frequencies.lowerBound(prefix); it != frequencies.end() && it.key().startsWith(prefix); ++it)
+    {
+        if (it.key() != prefix)
+        {
+            matches.append(qMakePair(it.value(), it.key()));
+        }
+    }
+
+    auto byFrequency = [](const QPair<int, QString> &a, const QPair<int, QString> &b) {
+        return a.first > b.first || (a.first == b.first && a.second < b.second);
+    };
+
+    int resultCount = qMin(maxResults, matches.size());
+    std::partial_sort(matches.begin(), matches.begin() + resultCount, matches.end(), byFrequency);
+
+    QStringList completions;
+    for (int i = 0; i < resultCount; i++)
+    {
+        completions.append(matches.at(i).second);
+    }
+
+    return completions;
+}
+
+
+// Заново разбивает текст блока на идентификаторы и заменяет ими прежние вхождения блока.
+void IdentifierIndex::reindexBlock(QTextBlock block)
+{
+    IdentifierBlockData *data = dynamic_cast<IdentifierBlockData*>(block.userData());
+
+    if (data == nullptr)
+    {
+        data = new IdentifierBlockData(this);
+        block.setUserData(data);
+    }
+
+    for (const QString &identifier : data->identifiers)
+    {
+        remove(identifier);
+    }
+    data->identifiers.clear();
+
+    const QString text = block.text();
+    int length = text.length();
+    int i = 0;
+
+    while (i < length)
+    {
+        QChar character = text.at(i);
+
+        // Идентификатор: буква или '_', затем буквы, цифры или '_'
+        if (character.isLetter() || character == '_')
+        {
+            int start = i;
+            while (i < length && (text.at(i).isLetterOrNumber() || text.at(i) == '_'))
+            {
+                i++;
+            }
+
+            if (i - start >= MIN_IDENTIFIER_LENGTH)
+            {
+                data->identifiers.append(add(text.mid(start, i - start)));
+            }
+        }
+
+        // Числовые литералы (например, 0x1F или 10ul) пропускаем целиком
+        else if (character.isDigit())
+        {
+            while (i < length && (text.at(i).isLetterOrNumber() || text.at(i) == '_'))
+            {
+                i++;
+            }
+        }
+
+        else
+        {
+            i++;
+        }
+    }
+}
+
+
+// Увеличивает частоту идентификатора и возвращает общий с картой экземпляр строки.
+QString IdentifierIndex::add(const QString &identifier)
+{
+    auto it = frequencies.find(identifier);
+
+    if (it == frequencies.end())
+    {
+        it = frequencies.insert(identifier, 0);
+        bytes += entryCost(identifier);
+    }
+
+    it.value()++;
+    bytes += sizeof(QString);
+    return it.key();
+}
+
+
+// Уменьшает частоту идентификатора и удаляет его из карты, когда вхождений не осталось.
+void IdentifierIndex::remove(const QString &identifier)
+{
+    auto it = frequencies.find(identifier);
+
+    if (it == frequencies.end())
+    {
+        return;
+    }
+
+    bytes -= sizeof(QString);
+
+    if (--it.value() == 0)
+    {
+        bytes -= entryCost(identifier);
+        frequencies.erase(it);
+    }
+}
+
+
+// Приблизительная стоимость одного узла карты вместе с данными строки-ключа.
+qint64 IdentifierIndex::entryCost(const QString &identifier)
+{
+    const qint64 mapNodeOverhead = 3 * sizeof(void*) + sizeof(QString) + sizeof(int);
+    return mapNodeOverhead + sizeof(QArrayData) + (identifier.length() + 1) * sizeof(QChar);
+}
@@ -0,0 +1,45 @@
+#ifndef IDENTIFIERINDEX_H
+#define IDENTIFIERINDEX_H
+#include <QMap>
+#include <QString>
+#include <QStringList>
+#include <QTextDocument>
+#include <QTextBlock>
+
+
+/* Индекс идентификаторов документа для автодополнения. Хранит отсортированную карту
+   идентификатор -> частота, которая обновляется инкрементально: при каждом contentsChange
+   заново разбираются только измененные блоки. Идентификаторы каждого блока хранятся
+   в его QTextBlockUserData, поэтому удаленные блоки сами вычитают свои вхождения.
+ */
+class IdentifierIndex
+{
+    Q_DISABLE_COPY(IdentifierIndex)
+
+public:
+    IdentifierIndex(){}
+    ~IdentifierIndex();
+
+    void attach(QTextDocument *document);
+    void update(int position, int charsRemoved, int charsAdded);
+    QStringList complete(const QString &prefix, int maxResults) const;
+
+    inline int size() const { return frequencies.size(); }
+    inline qint64 memoryUsage() const { return bytes; }
+
+    const static int MIN_IDENTIFIER_LENGTH = 3;
+
+private:
+    friend class IdentifierBlockData;
+
+    void reindexBlock(QTextBlock block);
+    QString add(const QString &identifier);
+    void remove(const QString &identifier);
+    static qint64 entryCost(const QString &identifier);
+
+    QTextDocument *document = nullptr;
+    QMap<QString, int> frequencies;
+    qint64 bytes = 0;
+};
+
+#endif // IDENTIFIERINDEX_H
@@ -1,4 +1,5 @@
 #include "language.h"
+#include <QMap>
 
 
 QString ProgrammingLanguage::toString(Language language)
@@ -17,3 +18,27 @@ QString ProgrammingLanguage::toString(Language language)
             return "Language not selected";
     }
 }
+
+
+/* Определяет язык по расширению имени файла (все после первой точки).
+   Для файлов без расширения или с неизвестным расширением возвращает Language::None.
+ */
+Language ProgrammingLanguage::fromFileName(const QString &fileName)
+{
+    static const QMap<QString, Language> extensionToLanguage = {
+        {"cpp", Language::CPP},
+        {"h", Language::CPP},
+        {"c", Language::C},
+        {"java", Language::Java},
+        {"py", Language::Python}
+    };
+
+    int indexOfDot = fileName.indexOf('.');
+
+    if (indexOfDot == -1)
+    {
+        return Language::None;
+    }
+
+    return extensionToLanguage.value(fileName.mid(indexOfDot + 1), Language::None);
+}
@@ -15,6 +15,7 @@ namespace ProgrammingLanguage
     };
 
     QString toString(Language language);
+    Language fromFileName(const QString &fileName);
 }
 
 #endif // LANGUAGE_H
@@ -0,0 +1,154 @@
+#include "latencymonitor.h"
+#include <QtDebug>
+#include <algorithm>
+
+
+bool LatencyMonitor::enabled = false;
+
+
+LatencyMonitor::LatencyMonitor()
+{
+    clock.start();
+}
+
+
+// Возвращает синглтон LatencyMonitor.
+LatencyMonitor *LatencyMonitor::instance()
+{
+    static LatencyMonitor singleton;
+    return &singleton;
+}
+
+
+// Включает или выключает сбор. При выключении накопленные замеры сбрасываются.
+void LatencyMonitor::setEnabled(bool enable)
+{
+    enabled = enable;
+    pendingKeyPress = -1;
+
+    if (!enable)
+    {
+        for (Samples &section : samples)
+        {
+            section.values.clear();
+            section.next = 0;
+        }
+    }
+}
+
+
+// Добавляет замер участка, вытесняя самый старый, когда буфер заполнен.
+void LatencyMonitor::record(Section section, qint64 nanoseconds)
+{
+    if (!enabled)
+    {
+        return;
+    }
+
+    Samples &target = samples[section];
+
+    if (target.values.size() < SAMPLES_PER_SECTION)
+    {
+        target.values.append(nanoseconds);
+    }
+    else
+    {
+        target.values[target.next] = nanoseconds;
+        target.next = (target.next + 1) % SAMPLES_PER_SECTION;
+    }
+}
+
+
+// Запоминает время нажатия клавиши; задержка считается до ближайшей перерисовки.
+void LatencyMonitor::keyPressed()
+{
+    if (enabled && pendingKeyPress < 0)
+    {
+        pendingKeyPress = now();
+    }
+}
+
+
+// Вызывается в конце перерисовки области просмотра редактора.
+void LatencyMonitor::framePainted()
+{
+    if (enabled && pendingKeyPress >= 0)
+    {
+        record(KeyToPaint, now() - pendingKeyPress);
+        pendingKeyPress = -1;
+    }
+}
+
+
+/* Считает перцентили по копии буфера через nth_element (O(n)) и раскладывает замеры
+   по корзинам: корзина i содержит замеры от 2^(i-1) до 2^i микросекунд.
+ */
+LatencyMonitor::Summary LatencyMonitor::summarize(Section section) const
+{
+    Summary summary;
+    summary.histogram.fill(0, HISTOGRAM_BUCKETS);
+
+    QVector<qint64> values = samples[section].values;
+    summary.samples = values.size();
+
+    if (values.isEmpty())
+    {
+        return summary;
+    }
+
+    for (qint64 &value : values)
+    {
+        value /= 1000;
+
+        int bucket = 0;
+        while (bucket < HISTOGRAM_BUCKETS - 1 && (qint64(1) << bucket) <= value)
+        {
+            bucket++;
+        }
+        summary.histogram[bucket]++;
+    }
+
+    auto percentile = [&values](int percent) {
+        auto nth = values.begin() + (values.size() - 1) * percent / 100;
+        std::nth_element(values.begin(), nth, values.end());
+        return *nth;
+    };
+
+    summary.p50 = percentile(50);
+    summary.p99 = percentile(99);
+    summary.max = *std::max_element(values.begin(), values.end());
+    return summary;
+}
+
+
+// Пишет сводку по всем участкам в журнал приложения.
+void LatencyMonitor::logSummaries() const
+{
+    for (int section = 0; section < SECTION_COUNT; section++)
+    {
+        Summary summary = summarize(Section(section));
+
+        if (summary.samples > 0)
+        {
+            qInfo().noquote() << QString("latency %1: p50=%2us p99=%3us max=%4us n=%5")
+                                 .arg(sectionName(Section(section))).arg(summary.p50).arg(summary.p99)
+                                 .arg(summary.max).arg(summary.samples);
+        }
+    }
+}
+
+
+QString LatencyMonitor::sectionName(Section section)
+{
+    switch (section)
+    {
+        case KeyToPaint: return "key to paint";
+        case EditAndLayout: return "edit + layout";
+        case TextChanged: return "on_textChanged";
+        case CursorPositionChanged: return "on_cursorPositionChanged";
+        case HighlightBlock: return "highlightBlock";
+        case LineNumberPaint: return "line numbers";
+        case FramePaint: return "frame";
+        default: return QString();
+    }
+}
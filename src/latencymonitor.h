@@ -0,0 +1,98 @@
+#ifndef LATENCYMONITOR_H
+#define LATENCYMONITOR_H
+#include <QElapsedTimer>
+#include <QString>
+#include <QVector>
+
+
+/* Сбор задержек ввода и времени кадров. Для каждого участка хранятся последние
+   SAMPLES_PER_SECTION замеров в кольцевом буфере, по которым считаются p50/p99 и
+   гистограмма по степеням двойки микросекунд. Пока сбор выключен, замер стоит одну
+   проверку статического флага. Все замеры делаются в потоке GUI.
+ */
+class LatencyMonitor
+{
+public:
+    enum Section
+    {
+        KeyToPaint = 0,           // от нажатия клавиши до первой перерисовки после него
+        EditAndLayout,            // правка документа вместе с раскладкой и подсветкой
+        TextChanged,
+        CursorPositionChanged,
+        HighlightBlock,
+        LineNumberPaint,
+        FramePaint,
+        SECTION_COUNT
+    };
+
+    // Сводка участка; времена в микросекундах
+    struct Summary
+    {
+        int samples = 0;
+        qint64 p50 = 0;
+        qint64 p99 = 0;
+        qint64 max = 0;
+        QVector<int> histogram;
+    };
+
+    static LatencyMonitor *instance();
+    static inline bool isEnabled() { return enabled; }
+    void setEnabled(bool enable);
+
+    inline qint64 now() const { return clock.nsecsElapsed(); }
+    void record(Section section, qint64 nanoseconds);
+    void keyPressed();
+    void framePainted();
+
+    Summary summarize(Section section) const;
+    void logSummaries() const;
+    static QString sectionName(Section section);
+
+    const static int SAMPLES_PER_SECTION = 1024;
+    const static int HISTOGRAM_BUCKETS = 16;
+
+// Singleton
+private:
+    LatencyMonitor();
+    LatencyMonitor(const LatencyMonitor& other);
+    LatencyMonitor &operator=(const LatencyMonitor& other);
+
+    struct Samples
+    {
+        QVector<qint64> values;
+        int next = 0;
+    };
+
+    static bool enabled;
+    QElapsedTimer clock;
+    Samples samples[SECTION_COUNT];
+    qint64 pendingKeyPress = -1;
+};
+
+
+/* Замер участка кода на время жизни объекта:
+       LatencyProbe probe(LatencyMonitor::TextChanged);
+ */
+class LatencyProbe
+{
+    Q_DISABLE_COPY(LatencyProbe)
+
+public:
+    inline LatencyProbe(LatencyMonitor::Section section)
+        : section(section), start(LatencyMonitor::isEnabled() ? LatencyMonitor::instance()->now() : -1) {}
+
+    inline ~LatencyProbe()
+    {
+        if (start >= 0)
+        {
+            LatencyMonitor *monitor = LatencyMonitor::instance();
+            monitor->record(section, monitor->now() - start);
+        }
+    }
+
+private:
+    LatencyMonitor::Section section;
+    qint64 start;
+};
+
+#endif // LATENCYMONITOR_H
@@ -0,0 +1,105 @@
+#include "latencyoverlay.h"
+#include <QPainter>
+
+
+// Создает скрытую панель; сбор замеров включается и выключается вместе с ее видимостью.
+LatencyOverlay::LatencyOverlay(QWidget *parent) : QWidget(parent)
+{
+    setAttribute(Qt::WA_TransparentForMouseEvents);
+    resize(nameWidth + valuesWidth + LatencyMonitor::HISTOGRAM_BUCKETS * barWidth + 20,
+           LatencyMonitor::SECTION_COUNT * rowHeight + 10);
+    hide();
+
+    refreshTimer = new QTimer(this);
+    refreshTimer->setInterval(REFRESH_INTERVAL_MS);
+    connect(refreshTimer, SIGNAL(timeout()), this, SLOT(refresh()));
+}
+
+
+void LatencyOverlay::showEvent(QShowEvent *event)
+{
+    QWidget::showEvent(event);
+    LatencyMonitor::instance()->setEnabled(true);
+    placeInParentCorner();
+    raise();
+    refreshTimer->start();
+}
+
+
+// При скрытии панели пишет итоговую сводку и выключает сбор, чтобы замеры снова ничего не стоили.
+void LatencyOverlay::hideEvent(QHideEvent *event)
+{
+    QWidget::hideEvent(event);
+    refreshTimer->stop();
+
+    if (LatencyMonitor::isEnabled())
+    {
+        LatencyMonitor::instance()->logSummaries();
+        LatencyMonitor::instance()->setEnabled(false);
+    }
+}
+
+
+void LatencyOverlay::refresh()
+{
+    placeInParentCorner();
+    update();
+
+    if (++ticksSinceLog * REFRESH_INTERVAL_MS >= LOG_INTERVAL_MS)
+    {
+        ticksSinceLog = 0;
+        LatencyMonitor::instance()->logSummaries();
+    }
+}
+
+
+void LatencyOverlay::placeInParentCorner()
+{
+    if (parentWidget())
+    {
+        move(parentWidget()->width() - width() - 10, 10);
+    }
+}
+
+
+/* Для каждого участка рисует имя, p50/p99 в миллисекундах и гистограмму, в которой
+   высота столбца пропорциональна доле замеров в корзине.
+ */
+void LatencyOverlay::paintEvent(QPaintEvent *event)
+{
+    Q_UNUSED(event)
+
+    QPainter painter(this);
+    painter.fillRect(rect(), QColor(0, 0, 0, 170));
+    painter.setPen(Qt::white);
+
+    LatencyMonitor *monitor = LatencyMonitor::instance();
+
+    for (int section = 0; section < LatencyMonitor::SECTION_COUNT; section++)
+    {
+        LatencyMonitor::Summary summary = monitor->summarize(LatencyMonitor::Section(section));
+        int top = 5 + section * rowHeight;
+
+        painter.drawText(QRect(8, top, nameWidth, rowHeight), Qt::AlignVCenter,
+                         LatencyMonitor::sectionName(LatencyMonitor::Section(section)));
+
+        if (summary.samples == 0)
+        {
+            continue;
+        }
+
+        painter.drawText(QRect(8 + nameWidth, top, valuesWidth, rowHeight), Qt::AlignVCenter,
+                         QString("%1 / %2 ms").arg(summary.p50 / 1000.0, 0, 'f', 2).arg(summary.p99 / 1000.0, 0, 'f', 2));
+
+        int histogramLeft = 8 + nameWidth + valuesWidth;
+        for (int bucket = 0; bucket < LatencyMonitor::HISTOGRAM_BUCKETS; bucket++)
+        {
+            int barHeight = (rowHeight - 4) * summary.histogram.at(bucket) / summary.samples;
+            if (barHeight > 0)
+            {
+                painter.fillRect(histogramLeft + bucket * barWidth, top + rowHeight - 2 - barHeight,
+                                 barWidth - 1, barHeight, QColor(120, 200, 255));
+            }
+        }
+    }
+}
@@ -0,0 +1,42 @@
+#ifndef LATENCYOVERLAY_H
+#define LATENCYOVERLAY_H
+#include "latencymonitor.h"
+#include <QWidget>
+#include <QTimer>
+
+
+/* Полупрозрачная панель поверх родительского виджета с p50/p99 и гистограммой
+   каждого участка LatencyMonitor. Обновляется по таймеру, только пока видима,
+   и раз в LOG_INTERVAL_MS пишет сводку в журнал.
+ */
+class LatencyOverlay : public QWidget
+{
+    Q_OBJECT
+
+public:
+    LatencyOverlay(QWidget *parent);
+
+    const static int REFRESH_INTERVAL_MS = 500;
+    const static int LOG_INTERVAL_MS = 10000;
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void showEvent(QShowEvent *event) override;
+    void hideEvent(QHideEvent *event) override;
+
+private slots:
+    void refresh();
+
+private:
+    void placeInParentCorner();
+
+    QTimer *refreshTimer;
+    int ticksSinceLog = 0;
+
+    const int rowHeight = 18;
+    const int nameWidth = 170;
+    const int valuesWidth = 150;
+    const int barWidth = 4;
+};
+
+#endif // LATENCYOVERLAY_H
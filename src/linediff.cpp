@@ -0,0 +1,151 @@
+#include "linediff.h"
+#include <algorithm>
+
+
+namespace
+{
+    // Одна строка, удаленная из старой версии или вставленная из новой; индексы - в позициях на момент правки
+    struct Step
+    {
+        bool insertion;
+        int oldIndex;
+        int newIndex;
+    };
+
+
+    /* Кратчайший путь правок между a[0, n) и b[0, m) (смещения begin). На каждом шаге d
+       сохраняется диагональный фронт, по которому путь затем восстанавливается с конца.
+       Возвращает false, если правок больше MAX_EDIT_DISTANCE.
+     */
+    bool shortestEdit(const QVector<QString> &a, int aBegin, int n,
+                      const QVector<QString> &b, int bBegin, int m, QVector<Step> &steps)
+    {
+        const int limit = qMin(n + m, LineDiff::MAX_EDIT_DISTANCE);
+        const int offset = limit + 1;
+        QVector<int> frontier(2 * limit + 3, 0);
+        QVector<QVector<int>> trace;
+
+        int distance = -1;
+        for (int d = 0; d <= limit && distance < 0; d++)
+        {
+            for (int k = -d; k <= d; k += 2)
+            {
+                bool down = k == -d || (k != d && frontier[offset + k - 1] < frontier[offset + k + 1]);
+                int x = down ? frontier[offset + k + 1] : frontier[offset + k - 1] + 1;
+                int y = x - k;
+
+                while (x < n && y < m && a.at(aBegin + x) == b.at(bBegin + y))
+                {
+                    x++;
+                    y++;
+                }
+
+                frontier[offset + k] = x;
+
+                if (x >= n && y >= m)
+                {
+                    distance = d;
+                }
+            }
+
+            trace.append(frontier.mid(offset - d, 2 * d + 1));
+        }
+
+        if (distance < 0)
+        {
+            return false;
+        }
+
+        int x = n;
+        int y = m;
+        for (int d = distance; d > 0; d--)
+        {
+            const QVector<int> &previous = trace.at(d - 1);
+            int k = x - y;
+
+            // Фронт шага d - 1 хранится для диагоналей [-(d - 1), d - 1]
+            auto previousX = [&previous, d](int diagonal) { return previous.at(diagonal + d - 1); };
+            bool down = k == -d || (k != d && previousX(k - 1) < previousX(k + 1));
+            int previousK = down ? k + 1 : k - 1;
+            int startX = previousX(previousK);
+            int startY = startX - previousK;
+
+            steps.append({down, startX, startY});
+            x = startX;
+            y = startY;
+        }
+
+        std::reverse(steps.begin(), steps.end());
+        return true;
+    }
+}
+
+
+/* Возвращает куски правок в порядке возрастания oldStart. Куски не пересекаются,
+   поэтому их можно применять с последнего к первому по номерам строк старой версии.
+ */
+QVector<LineDiff::Hunk> LineDiff::diff(const QVector<QString> &oldLines, const QVector<QString> &newLines)
+{
+    int prefix = 0;
+    int commonLength = qMin(oldLines.size(), newLines.size());
+    while (prefix < commonLength && oldLines.at(prefix) == newLines.at(prefix))
+    {
+        prefix++;
+    }
+
+    int suffix = 0;
+    while (suffix < commonLength - prefix &&
+           oldLines.at(oldLines.size() - 1 - suffix) == newLines.at(newLines.size() - 1 - suffix))
+    {
+        suffix++;
+    }
+
+    int n = oldLines.size() - prefix - suffix;
+    int m = newLines.size() - prefix - suffix;
+    QVector<Hunk> hunks;
+
+    if (n == 0 && m == 0)
+    {
+        return hunks;
+    }
+
+    QVector<Step> steps;
+    if (!shortestEdit(oldLines, prefix, n, newLines, prefix, m, steps))
+    {
+        Hunk hunk;
+        hunk.oldStart = prefix;
+        hunk.oldCount = n;
+        hunk.newStart = prefix;
+        hunk.newLines = newLines.mid(prefix, m);
+        hunks.append(hunk);
+        return hunks;
+    }
+
+    // Соседние шаги без общих строк между ними сливаются в один кусок
+    for (const Step &step : steps)
+    {
+        int oldIndex = prefix + step.oldIndex;
+        int newIndex = prefix + step.newIndex;
+
+        bool continues = !hunks.isEmpty() && hunks.last().oldStart + hunks.last().oldCount == oldIndex &&
+                         hunks.last().newStart + hunks.last().newLines.size() == newIndex;
+        if (!continues)
+        {
+            Hunk hunk;
+            hunk.oldStart = oldIndex;
+            hunk.newStart = newIndex;
+            hunks.append(hunk);
+        }
+
+        if (step.insertion)
+        {
+            hunks.last().newLines.append(newLines.at(newIndex));
+        }
+        else
+        {
+            hunks.last().oldCount++;
+        }
+    }
+
+    return hunks;
+}
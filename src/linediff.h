@@ -0,0 +1,28 @@
+#ifndef LINEDIFF_H
+#define LINEDIFF_H
+#include <QString>
+#include <QVector>
+
+
+/* Построчная разность двух версий текста (алгоритм Майерса, O((N + M) * D)).
+   Общие начало и конец отбрасываются заранее, поэтому правка в одном месте большого файла
+   стоит один проход сравнения строк. Если разность больше MAX_EDIT_DISTANCE строк,
+   вся середина между общими началом и концом заменяется одним куском.
+ */
+namespace LineDiff
+{
+    // Строки [oldStart, oldStart + oldCount) старой версии заменяются строками newLines
+    struct Hunk
+    {
+        int oldStart = 0;
+        int oldCount = 0;
+        int newStart = 0;
+        QVector<QString> newLines;
+    };
+
+    QVector<Hunk> diff(const QVector<QString> &oldLines, const QVector<QString> &newLines);
+
+    const int MAX_EDIT_DISTANCE = 2000;
+}
+
+#endif // LINEDIFF_H
@@ -10,6 +10,7 @@ public:
 
 protected:
     void paintEvent(QPaintEvent *event) override { editor->lineNumberAreaPaintEvent(event); }
+    void mousePressEvent(QMouseEvent *event) override { editor->lineNumberAreaMousePressEvent(event); }
 
 private:
     Editor *editor;
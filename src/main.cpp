@@ -1,19 +1,66 @@
 #include "mainwindow.h"
+#include "batch.h"
+#include "startupprofile.h"
+#include "singleinstance.h"
 #include <QApplication>
+#include <QCommandLineParser>
+#include <QFileInfo>
 #include <QtDebug>
 #include <QSysInfo>
 
 
 int main(int argc, char *argv[])
 {
+    StartupProfile::start();
+
+    // Пакетный режим работает без окна; QTextDocument и подсветке нужен только QGuiApplication
+    if (Batch::isRequested(argc, argv))
+    {
+        if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM"))
+        {
+            qputenv("QT_QPA_PLATFORM", "offscreen");
+        }
+
+        QGuiApplication app(argc, argv);
+        app.setOrganizationName("Kerimov David, Slobodan Lelikov");
+        app.setApplicationName("Textr");
+        return Batch::run(app.arguments());
+    }
+
     QApplication app(argc, argv);
 
     app.setOrganizationName("Kerimov David, Slobodan Lelikov");
     app.setApplicationName("Textr");
 
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    QCommandLineOption newInstanceOption("new-instance", "Open a separate window instead of the running one.");
+    parser.addOption(newInstanceOption);
+    parser.addPositionalArgument("files", "Files to open in tabs.", "[files...]");
+    parser.process(app);
+
+    QStringList filePaths;
+    for (const QString &argument : parser.positionalArguments())
+    {
+        filePaths.append(QFileInfo(argument).absoluteFilePath());
+    }
+
+    // Уже запущенный экземпляр открывает файлы сам; этому процессу не нужны ни окно, ни настройки
+    SingleInstance instance;
+    if (!parser.isSet(newInstanceOption) && instance.forwardOrListen(filePaths))
+    {
+        return 0;
+    }
+
     MainWindow window;
     QApplication::setStyle("fusion");
+    QObject::connect(&instance, &SingleInstance::filesReceived, &window, &MainWindow::openFiles);
 
     window.show();
+    if (!filePaths.isEmpty())
+    {
+        window.openFiles(filePaths);
+    }
+
     return app.exec();
 }
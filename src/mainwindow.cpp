@@ -2,20 +2,27 @@
 #include "utilityfunctions.h"
 #include "ui_mainwindow.h"
 #include "settings.h"                   // хранит состояние приложение
+#include "startupprofile.h"
 #include <QtDebug>
 #include <QtPrintSupport/QPrinter>      // печать
 #include <QtPrintSupport/QPrintDialog>  // печать
 #include <QFileDialog>                  // открытие файла/сохранение
 #include <QFile>                        // директории файлов, IO
+#include <QFileInfo>
 #include <QTextStream>                  // файл IO
 #include <QStandardPaths>               // базовая открытая директория
 #include <QDateTime>                    // нынешнее время
 #include <QApplication>
 #include <QShortcut>
+#include <QPointer>
+#include <algorithm>
 
 
-// Устанавливает главное окно приложения (наследников + виджеты)
-
+/* Устанавливает главное окно приложения (наследников + виджеты). До первого кадра строится
+   только то, что нужно для показа текущей вкладки: диалоги поиска, перехода и памяти создаются
+   при первом обращении, подсветчики вкладок из сессии - при их загрузке, а остальная
+   настройка окна выполняется в finishStartup после первой отрисовки.
+ */
 MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent), ui(new Ui::MainWindow)
 {
     ui->setupUi(this);
@@ -32,32 +39,54 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent), ui(new Ui::MainWi
     // Рамка языковой метки
     setupLanguageOnStatusBar();
 
-    // Настройка диалогового окна поиска
-    findDialog = new FindDialog();
-    findDialog->setParent(this, Qt::Tool | Qt::MSWindowsFixedSizeDialogHint);
-
-    // Настройка диалогового окна перехода
-    gotoDialog = new GotoDialog();
-    gotoDialog->setParent(this, Qt::Tool | Qt::MSWindowsFixedSizeDialogHint);
-
     // Настройка редактора с вкладками
     tabbedEditor = ui->tabWidget;
     tabbedEditor->setTabsClosable(true);
 
+    prefetchTimer = new QTimer(this);
+    prefetchTimer->setSingleShot(true);
+    prefetchTimer->setInterval(PREFETCH_DELAY_MS);
+    connect(prefetchTimer, SIGNAL(timeout()), this, SLOT(prefetchNeighbourTabs()));
+
     // Добавил metric reporter и смоделировал переключение вкладок
     metricReporter = new MetricReporter();
     ui->statusBar->addPermanentWidget(metricReporter);
+    connectActiveEditorSignals();
     on_currentTabChanged(0);
 
+    // Панель задержек ввода; пока она скрыта, замеры в редакторе и подсветке ничего не стоят
+    latencyOverlay = new LatencyOverlay(tabbedEditor);
+    if (qEnvironmentVariableIsSet("TEXTR_LATENCY_OVERLAY"))
+    {
+        ui->actionLatency_Overlay->setChecked(true);
+        latencyOverlay->show();
+    }
+
+    // Трассировка с самого запуска; файл trace_event записывается при выходе
+    if (qEnvironmentVariableIsSet("TEXTR_TRACE"))
+    {
+        Tracer::instance()->setEnabled(true);
+        ui->actionRecord_Trace->setChecked(true);
+    }
+
+    // Периодический замер памяти вкладок, который следит за бюджетом; запускается после первого кадра
+    memoryTimer = new QTimer(this);
+    memoryTimer->setInterval(MEMORY_CHECK_INTERVAL_MS);
+    connect(memoryTimer, SIGNAL(timeout()), this, SLOT(refreshMemoryUsage()));
+
     // Подключил сигналы редактора с вкладками к их обработчикам
     connect(tabbedEditor, SIGNAL(currentChanged(int)), this, SLOT(on_currentTabChanged(int)));
     connect(tabbedEditor, SIGNAL(tabCloseRequested(int)), this, SLOT(closeTab(int)));
+    connect(FileWatcher::instance(), &FileWatcher::changedWhileUnsaved, this, &MainWindow::on_fileChangedWhileUnsaved);
 
     // Подключил сигналы действий к их обработчикам
     connect(ui->actionSave, SIGNAL(triggered()), this, SLOT(on_actionSaveTriggered()));
     connect(ui->actionSave_As, SIGNAL(triggered()), this, SLOT(on_actionSaveTriggered()));
     connect(ui->actionReplace, SIGNAL(triggered()), this, SLOT(on_actionFind_triggered()));
 
+    // Вкладки прошлого запуска; файлы читаются только при первом показе вкладки
+    restoreSession();
+
     // Приходится добавлять этот ярлык вручную, потому что мы не можем определить его с помощью графического редактора
     QShortcut *tabCloseShortcut = new QShortcut(QKeySequence("Ctrl+W"), this);
     QObject::connect(tabCloseShortcut, SIGNAL(activated()), this, SLOT(closeTabShortcut()));
@@ -65,9 +94,129 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent), ui(new Ui::MainWi
     // Для переноса слов и автоматического отступа
     matchFormatOptionsToEditorDefaults();
 
-    mapMenuLanguageOptionToLanguageType();
-    mapFileExtensionsToLanguages();
+    // Первая отрисовка текущей вкладки отмечает конец быстрого пути запуска (см. eventFilter)
+    editor->viewport()->installEventFilter(this);
+}
+
+
+/* Ловит первую отрисовку редактора после запуска. Остальная настройка окна откладывается
+   в очередь событий и выполняется сразу после кадра.
+ */
+bool MainWindow::eventFilter(QObject *watched, QEvent *event)
+{
+    if (event->type() == QEvent::Paint)
+    {
+        watched->removeEventFilter(this);
+        StartupProfile::firstPaint();
+        QTimer::singleShot(0, this, SLOT(finishStartup()));
+    }
+
+    return QMainWindow::eventFilter(watched, event);
+}
+
+
+/* Завершает запуск после первого кадра: то, что не нужно для показа окна, но нужно
+   до первого взаимодействия. Когда очередь событий дошла до этого вызова, окно готово к вводу.
+ */
+void MainWindow::finishStartup()
+{
+    TraceScope trace("MainWindow::finishStartup", "startup");
     appendShortcutsToToolbarTooltips();
+    memoryTimer->start();
+    StartupProfile::interactive();
+    offerRecovery();
+}
+
+
+/* Предлагает восстановить вкладки, несохраненные правки которых остались в журналах
+   аварийно завершенного запуска. Восстановленная вкладка помечается измененной и сразу
+   получает новый журнал; прочитанные журналы удаляются в любом случае.
+ */
+void MainWindow::offerRecovery()
+{
+    QVector<RecoveryJournal::Recovered> recovered = RecoveryJournal::findRecoverable();
+
+    if (recovered.isEmpty())
+    {
+        return;
+    }
+
+    QMessageBox::StandardButton answer = QMessageBox::question(this, "Recovery",
+        QString("Textr did not shut down properly. Restore %1 unsaved tab(s)?").arg(recovered.size()),
+        QMessageBox::Yes | QMessageBox::No, QMessageBox::Yes);
+
+    for (const RecoveryJournal::Recovered &entry : recovered)
+    {
+        if (answer == QMessageBox::Yes)
+        {
+            Editor *tab = new Editor();
+            tabbedEditor->add(tab, false);
+            tab->setPlainText(entry.text);
+
+            if (!entry.filePath.isEmpty())
+            {
+                tab->setCurrentFilePath(entry.filePath);
+                tab->setProgrammingLanguage(fromFileName(QFileInfo(entry.filePath).fileName()));
+            }
+
+            tab->setModifiedState(true);
+            tab->journalRecoveredText();
+        }
+
+        RecoveryJournal::remove(entry.id);
+    }
+}
+
+
+// Создает диалог поиска при первом обращении и подключает его к посреднику текущей вкладки.
+FindDialog *MainWindow::findDialogInstance()
+{
+    if (!findDialog)
+    {
+        findDialog = new FindDialog();
+        findDialog->setParent(this, Qt::Tool | Qt::MSWindowsFixedSizeDialogHint);
+
+        ActiveEditor *active = tabbedEditor->activeEditor();
+        connect(findDialog, &FindDialog::startFinding, active, &ActiveEditor::find);
+        connect(findDialog, &FindDialog::startReplacing, active, &ActiveEditor::replace);
+        connect(findDialog, &FindDialog::startReplacingAll, active, &ActiveEditor::replaceAll);
+        connect(active, &ActiveEditor::findResultReady, findDialog, &FindDialog::onFindResultReady);
+    }
+
+    return findDialog;
+}
+
+
+// Создает диалог перехода к строке при первом обращении.
+GotoDialog *MainWindow::gotoDialogInstance()
+{
+    if (!gotoDialog)
+    {
+        gotoDialog = new GotoDialog();
+        gotoDialog->setParent(this, Qt::Tool | Qt::MSWindowsFixedSizeDialogHint);
+
+        ActiveEditor *active = tabbedEditor->activeEditor();
+        connect(gotoDialog, &GotoDialog::gotoLine, active, &ActiveEditor::goTo);
+        connect(active, &ActiveEditor::gotoResultReady, gotoDialog, &GotoDialog::onGotoResultReady);
+    }
+
+    return gotoDialog;
+}
+
+
+// Создает окно памяти вкладок при первом обращении.
+MemoryView *MainWindow::memoryViewInstance()
+{
+    if (!memoryView)
+    {
+        memoryView = new MemoryView();
+        memoryView->setParent(this, Qt::Tool);
+        memoryView->setBudgetMegabytes(memoryBudgetMegabytes);
+        connect(memoryView, SIGNAL(budgetChanged(int)), this, SLOT(setMemoryBudget(int)));
+        connect(memoryView, SIGNAL(releaseRequested()), this, SLOT(releaseBackgroundCaches()));
+    }
+
+    return memoryView;
 }
 
 
@@ -121,17 +270,6 @@ void MainWindow::mapMenuLanguageOptionToLanguageType()
 }
 
 
-// Сопоставляет известные расширения файлов с языками, поддерживаемыми редактором.
-void MainWindow::mapFileExtensionsToLanguages()
-{
-    extensionToLanguageMap.insert("cpp", Language::CPP);
-    extensionToLanguageMap.insert("h", Language::CPP);
-    extensionToLanguageMap.insert("c", Language::C);
-    extensionToLanguageMap.insert("java", Language::Java);
-    extensionToLanguageMap.insert("py", Language::Python);
-}
-
-
 void MainWindow::appendShortcutsToToolbarTooltips()
 {
     for (QAction* action : ui->mainToolBar->actions())
@@ -155,6 +293,11 @@ MainWindow::~MainWindow()
  */
 void MainWindow::on_languageSelected(QAction* languageAction)
 {
+    if (menuActionToLanguageMap.isEmpty())
+    {
+        mapMenuLanguageOptionToLanguageType();
+    }
+
     Language language = menuActionToLanguageMap[languageAction];
     selectProgrammingLanguage(language);
 }
@@ -206,26 +349,7 @@ void MainWindow::triggerCorrespondingMenuLanguageOption(Language lang)
  */
 void MainWindow::setLanguageFromExtension()
 {
-    QString fileName = editor->getFileName();
-    int indexOfDot = fileName.indexOf('.');
-
-    if (indexOfDot == -1)
-    {
-        selectProgrammingLanguage(Language::None);
-        return;
-    }
-
-    QString fileExtension = fileName.mid(indexOfDot + 1);
-
-    bool extensionSupported = extensionToLanguageMap.find(fileExtension) != extensionToLanguageMap.end();
-
-    if (!extensionSupported)
-    {
-        selectProgrammingLanguage(Language::None);
-        return;
-    }
-
-    selectProgrammingLanguage(extensionToLanguageMap[fileExtension]);
+    selectProgrammingLanguage(fromFileName(editor->getFileName()));
 }
 
 
@@ -245,51 +369,31 @@ void MainWindow::selectProgrammingLanguage(Language language)
 }
 
 
-/* Отключает все сигналы, зависящие от кэшированного редактора/вкладки.
-   Используется в основном при изменении текущего редактора (например, при открытии новой вкладки).
+/* Один раз подключает строку состояния и действия окна к посреднику текущей вкладки
+   (см. ActiveEditor). При переключении вкладки соединения не меняются. Диалоги подключаются
+   при создании (findDialogInstance, gotoDialogInstance).
  */
-void MainWindow::disconnectEditorDependentSignals()
+void MainWindow::connectActiveEditorSignals()
 {
-    disconnect(findDialog, SIGNAL(startFinding(QString, bool, bool)), editor, SLOT(find(QString, bool, bool)));
-    disconnect(findDialog, SIGNAL(startReplacing(QString, QString, bool, bool)), editor, SLOT(replace(QString, QString, bool, bool)));
-    disconnect(findDialog, SIGNAL(startReplacingAll(QString, QString, bool, bool)), editor, SLOT(replaceAll(QString, QString, bool, bool)));
-    disconnect(gotoDialog, SIGNAL(gotoLine(int)), editor, SLOT(goTo(int)));
-    disconnect(editor, SIGNAL(findResultReady(QString)), findDialog, SLOT(onFindResultReady(QString)));
-    disconnect(editor, SIGNAL(gotoResultReady(QString)), gotoDialog, SLOT(onGotoResultReady(QString)));
+    ActiveEditor *active = tabbedEditor->activeEditor();
 
-    disconnect(editor, SIGNAL(wordCountChanged(int)), metricReporter, SLOT(updateWordCount(int)));
-    disconnect(editor, SIGNAL(charCountChanged(int)), metricReporter, SLOT(updateCharCount(int)));
-    disconnect(editor, SIGNAL(lineCountChanged(int, int)), metricReporter, SLOT(updateLineCount(int, int)));
-    disconnect(editor, SIGNAL(columnCountChanged(int)), metricReporter, SLOT(updateColumnCount(int)));
-    disconnect(editor, SIGNAL(fileContentsChanged()), this, SLOT(updateTabAndWindowTitle()));
+    // Редактор выдает не больше одного снимка метрик за кадр, а заголовки пересчитываются
+    // только при смене пути или признака изменения документа
+    connect(active, &ActiveEditor::metricsChanged, metricReporter, &MetricReporter::showMetrics);
+    connect(active, &ActiveEditor::titleStateChanged, this, &MainWindow::updateTabAndWindowTitle);
 
-    disconnect(editor, SIGNAL(undoAvailable(bool)), this, SLOT(toggleUndo(bool)));
-    disconnect(editor, SIGNAL(redoAvailable(bool)), this, SLOT(toggleRedo(bool)));
-    disconnect(editor, SIGNAL(copyAvailable(bool)), this, SLOT(toggleCopyAndCut(bool)));
-}
+    connect(active, &ActiveEditor::undoAvailable, this, &MainWindow::toggleUndo);
+    connect(active, &ActiveEditor::redoAvailable, this, &MainWindow::toggleRedo);
+    connect(active, &ActiveEditor::copyAvailable, this, &MainWindow::toggleCopyAndCut);
 
-
-/* Соединяет все сигналы и интервалы, зависящие от кэшированного редактора/вкладки.
-   Используется в основном при изменении текущего редактора (например, при открытии новой вкладки).
- */
-void MainWindow::reconnectEditorDependentSignals()
-{
-    connect(findDialog, SIGNAL(startFinding(QString, bool, bool)), editor, SLOT(find(QString, bool, bool)));
-    connect(findDialog, SIGNAL(startReplacing(QString, QString, bool, bool)), editor, SLOT(replace(QString, QString, bool, bool)));
-    connect(findDialog, SIGNAL(startReplacingAll(QString, QString, bool, bool)), editor, SLOT(replaceAll(QString, QString, bool, bool)));
-    connect(gotoDialog, SIGNAL(gotoLine(int)), editor, SLOT(goTo(int)));
-    connect(editor, SIGNAL(findResultReady(QString)), findDialog, SLOT(onFindResultReady(QString)));
-    connect(editor, SIGNAL(gotoResultReady(QString)), gotoDialog, SLOT(onGotoResultReady(QString)));
-
-    connect(editor, SIGNAL(wordCountChanged(int)), metricReporter, SLOT(updateWordCount(int)));
-    connect(editor, SIGNAL(charCountChanged(int)), metricReporter, SLOT(updateCharCount(int)));
-    connect(editor, SIGNAL(lineCountChanged(int, int)), metricReporter, SLOT(updateLineCount(int, int)));
-    connect(editor, SIGNAL(columnCountChanged(int)), metricReporter, SLOT(updateColumnCount(int)));
-    connect(editor, SIGNAL(fileContentsChanged()), this, SLOT(updateTabAndWindowTitle()));
-
-    connect(editor, SIGNAL(undoAvailable(bool)), this, SLOT(toggleUndo(bool)));
-    connect(editor, SIGNAL(redoAvailable(bool)), this, SLOT(toggleRedo(bool)));
-    connect(editor, SIGNAL(copyAvailable(bool)), this, SLOT(toggleCopyAndCut(bool)));
+    // Строка состояния берет готовый снимок метрик нового активного редактора или вида, без пересчета
+    connect(active, &ActiveEditor::editorChanged, this, [this](Editor *view) {
+        if (view)
+        {
+            metricReporter->showMetrics(view->getDocumentMetrics());
+            toggleCopyAndCut(view->textCursor().hasSelection());
+        }
+    });
 }
 
 
@@ -298,20 +402,24 @@ void MainWindow::reconnectEditorDependentSignals()
  */
 void MainWindow::on_currentTabChanged(int index)
 {
+    TraceScope trace("MainWindow::on_currentTabChanged", "tabs");
     // Происходит, когда закрывается последняя вкладка редактора с вкладками
     if (index == -1)
     {
         return;
     }
 
-    // Примечание: редактор будет иметь значение nullptr только при первом запуске, поэтому в этом случае edge это будет пропущено
-    if (editor != nullptr)
+    editor = tabbedEditor->currentTab();
+
+    // Выгруженная вкладка или вкладка из сессии загружается до того, как ее состояние попадет в окно.
+    // Если файл не прочитан, вкладку закрывает обработчик loadFailed (см. removeOnLoadFailure)
+    if (editor->isHibernated())
     {
-        disconnectEditorDependentSignals();
+        editor->rehydrate();
     }
+    prefetchTimer->start();
 
-    editor = tabbedEditor->currentTab();
-    reconnectEditorDependentSignals();
+    tabbedEditor->activeEditor()->setEditor(editor);
     editor->setFocus(Qt::FocusReason::TabFocusReason);
 
     Language tabLanguage = editor->getProgrammingLanguage();
@@ -336,24 +444,19 @@ void MainWindow::on_currentTabChanged(int index)
     // Обновите действия в главном окне, чтобы отразить доступные действия на текущей вкладке
     toggleRedo(editor->redoAvailable());
     toggleUndo(editor->undoAvailable());
-    toggleCopyAndCut(editor->textCursor().hasSelection());
 
     updateFormatMenuOptions();
 
 
-    // Нам необходимо обновить эту информацию вручную для внесения изменений в вкладку
-    DocumentMetrics metrics = editor->getDocumentMetrics();
     updateTabAndWindowTitle();
-    metricReporter->updateWordCount(metrics.wordCount);
-    metricReporter->updateCharCount(metrics.charCount);
-    metricReporter->updateLineCount(metrics.currentLine, metrics.totalLines);
-    metricReporter->updateColumnCount(metrics.currentColumn);
 }
 
 
 // Запускает диалоговое окно поиска, если оно еще не отображается, и устанавливает его фокус.
 void MainWindow::launchFindDialog()
 {
+    findDialogInstance();
+
     if (findDialog->isHidden())
     {
         findDialog->show();
@@ -367,6 +470,8 @@ void MainWindow::launchFindDialog()
 // Запускает диалоговое окно "Перейти к", если оно еще не отображается, и устанавливает его фокус.
 void MainWindow::launchGotoDialog()
 {
+    gotoDialogInstance();
+
     if (gotoDialog->isHidden())
     {
         gotoDialog->show();
@@ -392,10 +497,34 @@ void MainWindow::updateTabAndWindowTitle()
     }
 
     tabbedEditor->setTabText(tabbedEditor->currentIndex(), tabTitle);
+    tabbedEditor->setTabToolTip(tabbedEditor->currentIndex(), tabToolTipFor(editor));
     setWindowTitle(windowTitle + " - textr");
 }
 
 
+/* Во всплывающей подсказке вкладки показываем путь, объем индекса автодополнения
+   и последний замер памяти вкладки (см. refreshMemoryUsage).
+ */
+QString MainWindow::tabToolTipFor(Editor *tab)
+{
+    const IdentifierIndex &index = tab->getIdentifierIndex();
+    MemoryUsage memory = tab->getMemoryUsage();
+
+    QString tabToolTip = tab->getCurrentFilePath() + tr("\nCompletion index: %1 identifiers, %2 KB")
+                         .arg(index.size()).arg(index.memoryUsage() / 1024);
+    tabToolTip += tr("\nMemory: %1 KB (text %2, layout %3, formats %4, undo %5)")
+                  .arg(memory.total() / 1024).arg(memory.text / 1024).arg(memory.layout / 1024)
+                  .arg(memory.formats / 1024).arg(memory.undo / 1024);
+
+    if (tab->isHibernated())
+    {
+        tabToolTip += tr("\nHibernated");
+    }
+
+    return tabToolTip.trimmed();
+}
+
+
 /* Запускает диалоговое окно с запросом у пользователя, хочет ли он сохранить текущий файл.
    Если пользователь выберет "Нет" или закроет диалоговое окно, файл не будет сохранен.
    В противном случае, если они выберут "Да", файл будет сохранен.
@@ -445,6 +574,8 @@ bool MainWindow::on_actionSaveTriggered()
         editor->setCurrentFilePath(filePath);
     }
 
+    TraceScope trace("MainWindow::saveFile", "io");
+
     // Попытайтесь создать файловый дескриптор с заданным путем
     QFile file(editor->getCurrentFilePath());
     if (!file.open(QIODevice::WriteOnly | QFile::Text))
@@ -462,6 +593,7 @@ bool MainWindow::on_actionSaveTriggered()
     file.close();
 
     editor->setModifiedState(false);
+    editor->syncDiskState();
     updateTabAndWindowTitle();
     setLanguageFromExtension();
 
@@ -477,9 +609,6 @@ bool MainWindow::on_actionSaveTriggered()
  */
 void MainWindow::on_actionOpen_triggered()
 {
-    // Используется для перехода на новую вкладку, если уже есть открытый документ
-    bool openInCurrentTab = editor->isUntitled() && !editor->isUnsaved();
-
     QString openedFilePath;
     QString lastUsedDirectory = settings->value(DEFAULT_DIRECTORY_KEY).toString();
 
@@ -502,11 +631,36 @@ void MainWindow::on_actionOpen_triggered()
     QDir currentDirectory;
     settings->setValue(DEFAULT_DIRECTORY_KEY, currentDirectory.absoluteFilePath(openedFilePath));
 
+    openFile(openedFilePath);
+}
+
+
+/* Открывает файл во вкладке: в текущей, если она пустая и без изменений, иначе в новой.
+   Используется меню Open и файлами, переданными повторным запуском (см. openFiles).
+ */
+void MainWindow::openFile(const QString &openedFilePath)
+{
+    // Используется для перехода на новую вкладку, если уже есть открытый документ
+    bool openInCurrentTab = editor->isUntitled() && !editor->isUnsaved();
+
+    // Уже открытый файл не читается второй раз: копия документа удвоила бы память, а правки
+    // в двух копиях разошлись бы. Для второго вида файла есть разделение вкладки
+    for (Editor *tab : tabbedEditor->tabs())
+    {
+        if (!tab->isUntitled() && QFileInfo(tab->getCurrentFilePath()) == QFileInfo(openedFilePath))
+        {
+            tabbedEditor->setCurrentWidget(tab);
+            return;
+        }
+    }
+
+    TraceScope trace("MainWindow::openFile", "io");
+
     // Попытка создать файловый дескриптор для файла по заданному пути
     QFile file(openedFilePath);
     if (!file.open(QIODevice::ReadOnly | QFile::Text))
     {
-        QMessageBox::warning(this, "Warning", "Cannot save file: " + file.errorString());
+        QMessageBox::warning(this, "Warning", "Cannot open file: " + file.errorString());
         return;
     }
 
@@ -523,11 +677,111 @@ void MainWindow::on_actionOpen_triggered()
     file.close();
 
     editor->setModifiedState(false);
+    editor->syncDiskState();
     updateTabAndWindowTitle();
     setLanguageFromExtension();
 }
 
 
+/* Открывает файлы из командной строки или от повторного запуска (см. SingleInstance)
+   и поднимает окно. Вкладки создаются сразу заглушками (см. Editor::deferLoading), а файлы
+   читаются и декодируются параллельно в пуле потоков; каждая вкладка заполняется, как только
+   прочитан ее файл. Текущей становится вкладка первого файла. Пустой список только поднимает окно.
+ */
+void MainWindow::openFiles(const QStringList &filePaths)
+{
+    TraceScope trace("MainWindow::openFiles", "io");
+    Editor *initialTab = editor;
+    Editor *firstTab = nullptr;
+    QVector<Editor*> openTabs = tabbedEditor->tabs();
+
+    for (const QString &filePath : filePaths)
+    {
+        Editor *tab = nullptr;
+
+        // Уже открытый файл не читается второй раз (см. openFile)
+        for (Editor *openTab : openTabs)
+        {
+            if (!openTab->isUntitled() && QFileInfo(openTab->getCurrentFilePath()) == QFileInfo(filePath))
+            {
+                tab = openTab;
+                break;
+            }
+        }
+
+        if (!tab)
+        {
+            tab = new Editor();
+            tab->deferLoading(filePath, 0);
+            tab->setProgrammingLanguage(fromFileName(QFileInfo(filePath).fileName()));
+            tabbedEditor->add(tab, false);
+            openTabs.append(tab);
+            removeOnLoadFailure(tab);
+            tab->loadInBackground();
+        }
+
+        if (!firstTab)
+        {
+            firstTab = tab;
+        }
+    }
+
+    if (firstTab)
+    {
+        tabbedEditor->setCurrentWidget(firstTab);
+
+        // Пустая стартовая вкладка больше не нужна, как и при восстановлении сессии
+        if (initialTab != firstTab && initialTab->isUntitled() && !initialTab->isUnsaved())
+        {
+            tabbedEditor->remove(initialTab);
+        }
+    }
+
+    setWindowState(windowState() & ~Qt::WindowMinimized);
+    show();
+    raise();
+    activateWindow();
+}
+
+
+/* Файл вкладки с несохраненными правками изменился на диске. Пользователь выбирает между
+   версией с диска (правки отбрасываются) и своей; во втором случае изменение на диске
+   запоминается, чтобы не спрашивать о нем снова, и будет перезаписано при сохранении.
+ */
+void MainWindow::on_fileChangedWhileUnsaved(Editor *tab)
+{
+    // Пока открыт вопрос, файл может измениться еще раз
+    if (reloadPrompts.contains(tab))
+    {
+        return;
+    }
+
+    reloadPrompts.insert(tab);
+    QPointer<Editor> guardedTab = tab;
+
+    QMessageBox::StandardButton answer = QMessageBox::question(this, "File changed",
+        tab->getFileName() + " has been changed on disk. Reload it and discard your changes?",
+        QMessageBox::Yes | QMessageBox::No, QMessageBox::No);
+
+    reloadPrompts.remove(tab);
+
+    // Вкладку могли закрыть, пока был открыт вопрос
+    if (!guardedTab)
+    {
+        return;
+    }
+
+    if (answer == QMessageBox::Yes)
+    {
+        tab->reloadFromDisk(true);
+    }
+    else
+    {
+        tab->syncDiskState();
+    }
+}
+
+
 /* Вызывается, когда пользователь выбирает опцию печати в меню или на панели инструментов (или использует сочетание клавиш Ctrl+P).
    Позволяет пользователю распечатать содержимое текущего документа.
  */
@@ -581,8 +835,7 @@ bool MainWindow::closeTab(Editor *tabToClose)
         }
     }
 
-    int indexOfTabToClose = tabbedEditor->indexOf(tabToClose);
-    tabbedEditor->removeTab(indexOfTabToClose);
+    tabbedEditor->remove(tabToClose);
 
     // Если закрыл последнюю вкладку, создает новую
     if (tabbedEditor->count() == 0)
@@ -618,6 +871,14 @@ void MainWindow::on_actionExit_triggered()
     }
 
     writeSettings();
+    settings->sync();
+
+    if (Tracer::isEnabled())
+    {
+        QString tracePath = qEnvironmentVariable("TEXTR_TRACE");
+        saveTrace(tracePath.isEmpty() || tracePath == "1" ? QDir(QDir::tempPath()).filePath(TRACE_FILE_NAME) : tracePath);
+    }
+
     QApplication::quit();
 }
 
@@ -632,6 +893,119 @@ void MainWindow::writeSettings()
     settings->setValue(WINDOW_POSITION_KEY, pos());
     settings->setValue(WINDOW_STATUS_BAR, ui->statusBar->isVisible());
     settings->setValue(WINDOW_TOOL_BAR, ui->mainToolBar->isVisible());
+    writeSession();
+}
+
+
+/* Записывает сессию: для каждой вкладки с файлом - путь, позицию курсора и язык,
+   а также номер текущей вкладки. Безымянные вкладки не сохраняются.
+ */
+void MainWindow::writeSession()
+{
+    QVariantList sessionTabs;
+    int currentTab = 0;
+
+    for (Editor *tab : tabbedEditor->tabs())
+    {
+        if (tab->isUntitled())
+        {
+            continue;
+        }
+
+        if (tab == editor)
+        {
+            currentTab = sessionTabs.size();
+        }
+
+        QVariantMap sessionTab;
+        sessionTab["path"] = tab->getCurrentFilePath();
+        sessionTab["cursor"] = tab->sessionCursorPosition();
+        sessionTab["language"] = int(tab->getProgrammingLanguage());
+        sessionTabs.append(sessionTab);
+    }
+
+    settings->setValue(SESSION_TABS_KEY, sessionTabs);
+    settings->setValue(SESSION_CURRENT_TAB_KEY, currentTab);
+}
+
+
+/* Восстанавливает вкладки прошлой сессии заглушками (см. Editor::deferLoading): при запуске
+   не читается ни один файл, кроме текущей вкладки, поэтому время старта не зависит от
+   числа вкладок. Пустая стартовая вкладка закрывается.
+ */
+void MainWindow::restoreSession()
+{
+    QVariantList sessionTabs = settings->value(SESSION_TABS_KEY).toList();
+
+    if (sessionTabs.isEmpty())
+    {
+        return;
+    }
+
+    Editor *initialTab = editor;
+
+    for (const QVariant &entry : sessionTabs)
+    {
+        QVariantMap sessionTab = entry.toMap();
+        Editor *tab = new Editor();
+        tab->deferLoading(sessionTab.value("path").toString(), sessionTab.value("cursor").toInt());
+        tab->setProgrammingLanguage(Language(sessionTab.value("language").toInt()));
+        tabbedEditor->add(tab, false);
+        removeOnLoadFailure(tab);
+    }
+
+    int currentTab = qBound(0, settings->value(SESSION_CURRENT_TAB_KEY).toInt(), sessionTabs.size() - 1);
+    tabbedEditor->setCurrentIndex(tabbedEditor->indexOf(initialTab) + 1 + currentTab);
+
+    if (initialTab->isUntitled() && !initialTab->isUnsaved())
+    {
+        tabbedEditor->remove(initialTab);
+    }
+}
+
+
+/* Вкладка-заглушка (см. Editor::deferLoading), файл которой не удалось прочитать, сообщает об этом
+   и закрывается, чтобы сохранение пустой вкладки не затерло файл. Так обрабатываются и фоновая
+   загрузка, и загрузка при показе вкладки. Закрытие откладывается: loadFailed может прийти
+   из on_currentTabChanged, пока вкладка становится текущей.
+ */
+void MainWindow::removeOnLoadFailure(Editor *tab)
+{
+    QPointer<Editor> failedTab = tab;
+    connect(tab, &Editor::loadFailed, this, [this, failedTab]() {
+        // Пока вызов ждал в очереди, пользователь мог сам закрыть вкладку
+        if (failedTab.isNull())
+        {
+            return;
+        }
+
+        Editor *tab = failedTab.data();
+        QMessageBox::warning(this, "Warning", "Cannot open file: " + tab->getCurrentFilePath());
+        tabbedEditor->remove(tab);
+
+        if (tabbedEditor->count() == 0)
+        {
+            on_actionNew_triggered();
+        }
+    }, Qt::QueuedConnection);
+}
+
+
+/* Начинает чтение файлов соседних вкладок из сессии в пуле потоков, пока пользователь
+   работает с текущей: переход на соседнюю вкладку тогда не ждет диска.
+ */
+void MainWindow::prefetchNeighbourTabs()
+{
+    int current = tabbedEditor->currentIndex();
+
+    for (int offset : {1, -1, 2})
+    {
+        Editor *tab = tabbedEditor->tabAt(current + offset);
+        if (tab != nullptr)
+        {
+            tab->prefetch();
+        }
+    }
 }
 
 
@@ -649,6 +1023,9 @@ void MainWindow::readSettings() {
                         this->ui->actionStatus_Bar->setChecked(qvariant_cast<bool>(setting));
                     });
 
+    settings->apply(settings->value(MEMORY_BUDGET_KEY),
+                    [=](QVariant setting){ this->memoryBudgetMegabytes = setting.toInt(); });
+
     settings->apply(settings->value(WINDOW_TOOL_BAR),
                     [=](QVariant setting) {
                         this->ui->mainToolBar->setVisible(qvariant_cast<bool>(setting));
@@ -699,7 +1076,7 @@ void MainWindow::toggleCopyAndCut(bool copyCutAvailable) {
 void MainWindow::on_actionCut_triggered() {
     if (ui->actionCut->isEnabled())
     {
-        editor->cut();
+        focusedView()->cut();
     }
 }
 
@@ -708,14 +1085,14 @@ void MainWindow::on_actionCut_triggered() {
 void MainWindow::on_actionCopy_triggered() {
     if (ui->actionCopy->isEnabled())
     {
-        editor->copy();
+        focusedView()->copy();
     }
 }
 
 
 // Вызывается, когда пользователь выполняет операцию вставки.
 void MainWindow::on_actionPaste_triggered() {
-    editor->paste();
+    focusedView()->paste();
 }
 
 
@@ -737,7 +1114,7 @@ void MainWindow::on_actionGo_To_triggered() {
 
 // Вызывается, когда пользователь явно выбирает опцию Выбрать все в меню (или использует сочетание клавиш Ctrl+A).
 void MainWindow::on_actionSelect_All_triggered() {
-    editor->selectAll();
+    focusedView()->selectAll();
 }
 
 
@@ -745,7 +1122,9 @@ void MainWindow::on_actionSelect_All_triggered() {
 void MainWindow::on_actionTime_Date_triggered()
 {
     QDateTime currentTime = QDateTime::currentDateTime();
-    editor->insertPlainText(currentTime.toString());
+    Editor *view = focusedView();
+    view->preserveClipboardSnapshot(view->textCursor().selectionStart(), view->textCursor().selectionEnd());
+    view->insertPlainText(currentTime.toString());
 }
 
 
@@ -776,6 +1155,27 @@ void MainWindow::on_actionWord_Wrap_triggered()
 }
 
 
+// Вызывается, когда пользователь выбирает опцию переотступа документа в меню Формат.
+void MainWindow::on_actionReindent_Document_triggered()
+{
+    editor->reindentDocument();
+}
+
+
+// Вызывается, когда пользователь выбирает преобразование отступов в пробелы в меню Формат.
+void MainWindow::on_actionConvert_To_Spaces_triggered()
+{
+    editor->convertIndentation(true);
+}
+
+
+// Вызывается, когда пользователь выбирает преобразование отступов в табуляции в меню Формат.
+void MainWindow::on_actionConvert_To_Tabs_triggered()
+{
+    editor->convertIndentation(false);
+}
+
+
 /* Переключает видимость данного виджета. Предполагается, что этот
    виджет является частью главного окна. В противном случае эффект может быть незаметен.
  */
@@ -797,6 +1197,205 @@ void MainWindow::on_actionTool_Bar_triggered() {
 }
 
 
+// Сворачивает или разворачивает регион кода, начинающийся со строки курсора.
+void MainWindow::on_actionToggle_Fold_triggered()
+{
+    focusedView()->toggleFoldAtCursor();
+}
+
+
+// Сворачивает все регионы кода текущего документа.
+void MainWindow::on_actionFold_All_triggered()
+{
+    editor->foldAll();
+}
+
+
+// Разворачивает все регионы кода текущего документа.
+void MainWindow::on_actionUnfold_All_triggered()
+{
+    editor->unfoldAll();
+}
+
+
+/* Включает запись трассировки горячих участков. При выключении предлагает сохранить
+   записанное в файл, который открывается в chrome://tracing или Perfetto.
+ */
+void MainWindow::on_actionRecord_Trace_triggered()
+{
+    bool recording = ui->actionRecord_Trace->isChecked();
+    Tracer::instance()->setEnabled(recording);
+
+    if (recording)
+    {
+        return;
+    }
+
+    QString filePath = QFileDialog::getSaveFileName(this, tr("Save Trace"), QDir(DEFAULT_DIRECTORY).filePath(TRACE_FILE_NAME),
+                                                    tr("Chrome trace (*.json)"));
+
+    if (!filePath.isNull())
+    {
+        saveTrace(filePath);
+    }
+}
+
+
+// Записывает трассировку в файл в формате Chrome trace_event.
+void MainWindow::saveTrace(QString filePath)
+{
+    if (!Tracer::instance()->writeChromeTrace(filePath))
+    {
+        QMessageBox::warning(this, "Warning", "Cannot save trace: " + filePath);
+    }
+}
+
+
+// Показывает документ текущей вкладки в двух видах рядом.
+void MainWindow::on_actionSplit_Horizontally_triggered()
+{
+    tabbedEditor->split(Qt::Horizontal);
+}
+
+
+// Показывает документ текущей вкладки в двух видах друг под другом.
+void MainWindow::on_actionSplit_Vertically_triggered()
+{
+    tabbedEditor->split(Qt::Vertical);
+}
+
+
+// Закрывает вид разделения, в котором фокус.
+void MainWindow::on_actionClose_Split_triggered()
+{
+    tabbedEditor->closeSplit();
+}
+
+
+// Показывает окно памяти вкладок со свежим замером.
+void MainWindow::on_actionMemory_triggered()
+{
+    memoryViewInstance();
+    refreshMemoryUsage();
+    memoryView->show();
+    memoryView->raise();
+    memoryView->activateWindow();
+}
+
+
+/* Замеряет память всех вкладок и обновляет их подсказки и окно Memory. Фоновые вкладки,
+   которые не показывались дольше HIBERNATE_AFTER_MS и не имеют истории отмены, выгружаются.
+   Если сумма превышает бюджет, фоновые вкладки по убыванию объема сначала освобождают кэши,
+   а затем выгружаются, пока сумма не уложится в него. Выгрузка заново загружает текст
+   и теряет историю отмены, поэтому вкладки с несохраненными правками или историей
+   только освобождают кэши. Текущая вкладка ничего не теряет.
+ */
+void MainWindow::refreshMemoryUsage()
+{
+    QVector<Editor*> tabs = tabbedEditor->tabs();
+    qint64 budget = qint64(memoryBudgetMegabytes) << 20;
+    qint64 total = 0;
+
+    for (Editor *tab : tabs)
+    {
+        bool idle = tab != editor && tab->idleMilliseconds() >= HIBERNATE_AFTER_MS;
+        if (idle && !tab->isHibernated() && !tab->hasUndoHistory() &&
+            tab->document()->characterCount() >= MIN_HIBERNATION_CHARACTERS)
+        {
+            tab->hibernate();
+        }
+
+        total += tab->measureMemoryUsage().total();
+    }
+
+    if (budget > 0 && total > budget)
+    {
+        QVector<Editor*> backgroundTabs = tabs;
+        backgroundTabs.removeOne(editor);
+        std::sort(backgroundTabs.begin(), backgroundTabs.end(), [](Editor *first, Editor *second) {
+            return first->getMemoryUsage().total() > second->getMemoryUsage().total();
+        });
+
+        for (Editor *tab : backgroundTabs)
+        {
+            if (total <= budget)
+            {
+                break;
+            }
+
+            qint64 before = tab->getMemoryUsage().total();
+            tab->releaseCaches(UNDO_STEPS_TO_KEEP);
+            total -= before - tab->getMemoryUsage().total();
+        }
+
+        for (Editor *tab : backgroundTabs)
+        {
+            if (total <= budget)
+            {
+                break;
+            }
+
+            if (tab->isUnsaved() || tab->hasUndoHistory())
+            {
+                continue;
+            }
+
+            qint64 before = tab->getMemoryUsage().total();
+            if (tab->hibernate())
+            {
+                total -= before - tab->getMemoryUsage().total();
+            }
+        }
+    }
+
+    QVector<QString> tabNames;
+    QVector<MemoryUsage> usages;
+
+    for (int i = 0; i < tabs.size(); i++)
+    {
+        tabbedEditor->setTabToolTip(i, tabToolTipFor(tabs.at(i)));
+        tabNames.append(tabs.at(i)->getFileName() + (tabs.at(i)->isHibernated() ? tr(" (hibernated)") : QString()));
+        usages.append(tabs.at(i)->getMemoryUsage());
+    }
+
+    if (memoryView && memoryView->isVisible())
+    {
+        memoryView->showUsage(tabNames, usages, budget);
+    }
+}
+
+
+// Освобождает кэши всех фоновых вкладок независимо от бюджета (кнопка в окне Memory).
+void MainWindow::releaseBackgroundCaches()
+{
+    for (Editor *tab : tabbedEditor->tabs())
+    {
+        if (tab != editor)
+        {
+            tab->releaseCaches(UNDO_STEPS_TO_KEEP);
+        }
+    }
+
+    refreshMemoryUsage();
+}
+
+
+// Сохраняет новый бюджет памяти и сразу проверяет его.
+void MainWindow::setMemoryBudget(int megabytes)
+{
+    memoryBudgetMegabytes = megabytes;
+    settings->setValue(MEMORY_BUDGET_KEY, megabytes);
+    refreshMemoryUsage();
+}
+
+
+// Показывает или скрывает панель задержек ввода и времени кадров (вместе с их сбором).
+void MainWindow::on_actionLatency_Overlay_triggered()
+{
+    latencyOverlay->setVisible(ui->actionLatency_Overlay->isChecked());
+}
+
+
 /* Переопределяет виртуальный метод QWidget closeEvent. Вызывается, когда пользователь пытается
    закрыть главное окно приложения обычным способом с помощью красного крестика. Позволяет
    пользователю сохранить все несохраненные файлы перед выходом из системы.
@@ -8,12 +8,17 @@
 #include "tabbededitor.h"
 #include "language.h"
 #include "metricreporter.h"
+#include "latencyoverlay.h"
+#include "memoryview.h"
+#include "tracer.h"
 #include <code_highlighters/highlighter.h>
 #include <QMainWindow>
 #include <QCloseEvent>                  // closeEvent
 #include <QLabel>                       // GUI labels
 #include <QActionGroup>
 #include <QStandardPaths>               // see default directory
+#include <QTimer>
+#include <QSet>
 
 
 using namespace ProgrammingLanguage;
@@ -34,9 +39,17 @@ public:
     void launchGotoDialog();
     void closeEvent(QCloseEvent *event) override;
 
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) override;
+
 private:
-    void reconnectEditorDependentSignals();
-    void disconnectEditorDependentSignals();
+    // Бенчмарк запуска (../benchmarks) создает отложенные части окна напрямую
+    friend class EditorBenchmark;
+
+    void connectActiveEditorSignals();
+    FindDialog *findDialogInstance();
+    GotoDialog *gotoDialogInstance();
+    MemoryView *memoryViewInstance();
     QMessageBox::StandardButton askUserToSave();
 
     void appendShortcutsToToolbarTooltips();
@@ -44,15 +57,22 @@ private:
     void selectProgrammingLanguage(Language language);
     void triggerCorrespondingMenuLanguageOption(Language lang);
     void mapMenuLanguageOptionToLanguageType();
-    void mapFileExtensionsToLanguages();
     void setLanguageFromExtension();
 
     void matchFormatOptionsToEditorDefaults();
     void updateFormatMenuOptions();
     void writeSettings();
     void readSettings();
+    void writeSession();
+    void restoreSession();
+    void removeOnLoadFailure(Editor *tab);
+    void openFile(const QString &openedFilePath);
+    void offerRecovery();
 
     void toggleVisibilityOf(QWidget *widget);
+    void saveTrace(QString filePath);
+    inline Editor *focusedView() const { return tabbedEditor->activeEditor()->editor() ? tabbedEditor->activeEditor()->editor() : editor; }
+    QString tabToolTipFor(Editor *tab);
 
     // The "core" or essential members
     Ui::MainWindow *ui;
@@ -68,14 +88,34 @@ private:
     const QString WINDOW_TOOL_BAR = "window_tool_bar";
     const QString DEFAULT_DIRECTORY_KEY = "default_directory";
     const QString DEFAULT_DIRECTORY = QStandardPaths::writableLocation(QStandardPaths::DocumentsLocation);
-
-    // Other widget members
-    FindDialog *findDialog;
-    GotoDialog *gotoDialog;
+    const QString TRACE_FILE_NAME = "textr-trace.json";
+    const QString MEMORY_BUDGET_KEY = "memory_budget_mb";
+    const QString SESSION_TABS_KEY = "session_tabs";
+    const QString SESSION_CURRENT_TAB_KEY = "session_current_tab";
+
+    // Соседние с текущей вкладки из сессии читаются заранее, когда пользователь задержался на вкладке
+    const static int PREFETCH_DELAY_MS = 1000;
+    QTimer *prefetchTimer;
+
+    // Учет памяти вкладок: замер по таймеру и бюджет (0 - без ограничения)
+    const static int MEMORY_CHECK_INTERVAL_MS = 5000;
+    const static int UNDO_STEPS_TO_KEEP = 100;
+    const static int HIBERNATE_AFTER_MS = 10 * 60 * 1000;
+    const static int MIN_HIBERNATION_CHARACTERS = 1 << 16;
+    int memoryBudgetMegabytes = 0;
+    QTimer *memoryTimer;
+
+    // Other widget members; диалоги и окно памяти создаются при первом обращении
+    FindDialog *findDialog = nullptr;
+    GotoDialog *gotoDialog = nullptr;
     QActionGroup *languageGroup;
     QLabel *languageLabel;
+    LatencyOverlay *latencyOverlay;
+    MemoryView *memoryView = nullptr;
     QMap<QAction*, Language> menuActionToLanguageMap;
-    QMap<QString, Language> extensionToLanguageMap;
+
+    // Вкладки, о внешнем изменении файла которых пользователь сейчас отвечает на вопрос
+    QSet<Editor*> reloadPrompts;
 
 public slots:
     void toggleUndo(bool undoAvailable);
@@ -86,10 +126,18 @@ public slots:
     bool closeTab(Editor *tabToClose);
     inline bool closeTab(int index) { return closeTab(tabbedEditor->tabAt(index)); }
     inline void closeTabShortcut() { closeTab(tabbedEditor->currentTab()); }
-    inline void informUser(QString title, QString message) { QMessageBox::information(findDialog, title, message); }
+    inline void informUser(QString title, QString message) { QMessageBox::information(findDialog ? static_cast<QWidget*>(findDialog) : this, title, message); }
+
+    void refreshMemoryUsage();
+    void releaseBackgroundCaches();
+    void setMemoryBudget(int megabytes);
+    void prefetchNeighbourTabs();
+    void openFiles(const QStringList &filePaths);
 
 // все шорткаты
 private slots:
+    void finishStartup();
+    void on_fileChangedWhileUnsaved(Editor *tab);
     void on_currentTabChanged(int index);
     void on_languageSelected(QAction* languageAction);
     void on_actionNew_triggered();
@@ -110,7 +158,19 @@ private slots:
     void on_actionFont_triggered();
     void on_actionAuto_Indent_triggered();
     void on_actionWord_Wrap_triggered();
+    void on_actionReindent_Document_triggered();
+    void on_actionConvert_To_Spaces_triggered();
+    void on_actionConvert_To_Tabs_triggered();
     void on_actionTool_Bar_triggered();
+    void on_actionToggle_Fold_triggered();
+    void on_actionFold_All_triggered();
+    void on_actionUnfold_All_triggered();
+    void on_actionLatency_Overlay_triggered();
+    void on_actionRecord_Trace_triggered();
+    void on_actionMemory_triggered();
+    void on_actionSplit_Horizontally_triggered();
+    void on_actionSplit_Vertically_triggered();
+    void on_actionClose_Split_triggered();
 };
 
 #endif // MAINWINDOW_H
@@ -0,0 +1,17 @@
+#ifndef MEMORYUSAGE_H
+#define MEMORYUSAGE_H
+#include <QtGlobal>
+
+// Приблизительный объем памяти вкладки в байтах по категориям (см. Editor::measureMemoryUsage)
+struct MemoryUsage
+{
+    qint64 text = 0;        // символы документа и узлы блоков
+    qint64 layout = 0;      // разложенные строки, глифы и плитки миникарты
+    qint64 formats = 0;     // форматы подсветки синтаксиса
+    qint64 undo = 0;        // стеки отмены и повтора
+    qint64 search = 0;      // история поиска и индекс автодополнения
+
+    inline qint64 total() const { return text + layout + formats + undo + search; }
+};
+
+#endif // MEMORYUSAGE_H
@@ -0,0 +1,90 @@
+#include "memoryview.h"
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QPushButton>
+#include <QHeaderView>
+
+
+// Таблица вкладок, строка с итогом и поле бюджета (0 - без ограничения).
+MemoryView::MemoryView(QWidget *parent) : QDialog(parent)
+{
+    table = new QTableWidget(0, 7, this);
+    table->setHorizontalHeaderLabels({tr("Tab"), tr("Text"), tr("Layout"), tr("Formats"),
+                                      tr("Undo"), tr("Search"), tr("Total")});
+    table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    table->setSelectionMode(QAbstractItemView::NoSelection);
+    table->verticalHeader()->hide();
+    table->horizontalHeader()->setSectionResizeMode(0, QHeaderView::Stretch);
+
+    totalLabel = new QLabel(this);
+
+    budgetSpinBox = new QSpinBox(this);
+    budgetSpinBox->setRange(0, 1 << 20);
+    budgetSpinBox->setSingleStep(64);
+    budgetSpinBox->setSuffix(" MB");
+    budgetSpinBox->setSpecialValueText(tr("No limit"));
+
+    QPushButton *releaseButton = new QPushButton(tr("Release Background Tabs"), this);
+
+    QHBoxLayout *budgetLayout = new QHBoxLayout();
+    budgetLayout->addWidget(new QLabel(tr("Budget:"), this));
+    budgetLayout->addWidget(budgetSpinBox);
+    budgetLayout->addStretch();
+    budgetLayout->addWidget(releaseButton);
+
+    QVBoxLayout *layout = new QVBoxLayout(this);
+    layout->addWidget(table);
+    layout->addWidget(totalLabel);
+    layout->addLayout(budgetLayout);
+
+    setWindowTitle(tr("Memory"));
+    resize(640, 300);
+
+    connect(budgetSpinBox, SIGNAL(valueChanged(int)), this, SIGNAL(budgetChanged(int)));
+    connect(releaseButton, SIGNAL(clicked()), this, SIGNAL(releaseRequested()));
+}
+
+
+// Заполняет таблицу замерами вкладок; budget в байтах (0 - без ограничения).
+void MemoryView::showUsage(const QVector<QString> &tabNames, const QVector<MemoryUsage> &usages, qint64 budget)
+{
+    table->setRowCount(usages.size());
+    qint64 total = 0;
+
+    for (int row = 0; row < usages.size(); row++)
+    {
+        const MemoryUsage &usage = usages.at(row);
+        const qint64 columns[] = {usage.text, usage.layout, usage.formats, usage.undo, usage.search, usage.total()};
+
+        table->setItem(row, 0, new QTableWidgetItem(tabNames.at(row)));
+        for (int column = 0; column < 6; column++)
+        {
+            QTableWidgetItem *item = new QTableWidgetItem(toKilobytes(columns[column]));
+            item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+            table->setItem(row, column + 1, item);
+        }
+
+        total += usage.total();
+    }
+
+    QString text = tr("Total: %1").arg(toKilobytes(total));
+    if (budget > 0)
+    {
+        text += tr(" of %1 budget").arg(toKilobytes(budget));
+    }
+    totalLabel->setText(text);
+}
+
+
+// Устанавливает значение поля бюджета без сигнала budgetChanged.
+void MemoryView::setBudgetMegabytes(int megabytes)
+{
+    QSignalBlocker blocker(budgetSpinBox);
+    budgetSpinBox->setValue(megabytes);
+}
+
+
+QString MemoryView::toKilobytes(qint64 bytes)
+{
+    return QString("%1 KB").arg(bytes / 1024);
+}
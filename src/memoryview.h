@@ -0,0 +1,36 @@
+#ifndef MEMORYVIEW_H
+#define MEMORYVIEW_H
+#include "memoryusage.h"
+#include <QDialog>
+#include <QLabel>
+#include <QSpinBox>
+#include <QTableWidget>
+#include <QVector>
+
+
+/* Окно "Memory": приблизительная память каждой вкладки по категориям и общий бюджет.
+   Сами замеры делает MainWindow по таймеру; окно только показывает последние.
+ */
+class MemoryView : public QDialog
+{
+    Q_OBJECT
+
+public:
+    MemoryView(QWidget *parent = nullptr);
+
+    void showUsage(const QVector<QString> &tabNames, const QVector<MemoryUsage> &usages, qint64 budget);
+    void setBudgetMegabytes(int megabytes);
+
+signals:
+    void budgetChanged(int megabytes);
+    void releaseRequested();
+
+private:
+    static QString toKilobytes(qint64 bytes);
+
+    QTableWidget *table;
+    QLabel *totalLabel;
+    QSpinBox *budgetSpinBox;
+};
+
+#endif // MEMORYVIEW_H
@@ -27,30 +27,31 @@ MetricReporter::MetricReporter(QWidget *parent) : QFrame(parent)
 }
 
 
-// Обновляет количество слов с использованием соответствующей метки.
-void MetricReporter::updateWordCount(int wordCount)
+/* Показывает снимок метрик активного редактора. setText перерисовывает метку и может
+   пересчитать раскладку строки состояния, поэтому обновляются только изменившиеся поля.
+ */
+void MetricReporter::showMetrics(const DocumentMetrics &metrics)
 {
-    wordCountLabel->setText(QString::number(wordCount));
+    if (!hasShown || metrics.wordCount != shown.wordCount)
+    {
+        wordCountLabel->setText(QString::number(metrics.wordCount));
+    }
+
+    if (!hasShown || metrics.charCount != shown.charCount)
+    {
+        charCountLabel->setText(QString::number(metrics.charCount));
+    }
+
+    if (!hasShown || metrics.currentLine != shown.currentLine || metrics.totalLines != shown.totalLines)
+    {
+        lineCountLabel->setText(QString::number(metrics.currentLine) + tr("/") + QString::number(metrics.totalLines));
+    }
+
+    if (!hasShown || metrics.currentColumn != shown.currentColumn)
+    {
+        columnCountLabel->setText(QString::number(metrics.currentColumn));
+    }
+
+    shown = metrics;
+    hasShown = true;
 }
-
-
-// Обновляет количество символов с использованием соответствующей метки.
-void MetricReporter::updateCharCount(int charCount)
-{
-    charCountLabel->setText(QString::number(charCount));
-}
-
-
-// Обновляет номер строки с использованием соответствующей метки.
-void MetricReporter::updateLineCount(int current, int total)
-{
-    lineCountLabel->setText(QString::number(current) + tr("/") + QString::number(total));
-}
-
-
-// Обновляет номер колонки с использованием соответствующей метки.
-void MetricReporter::updateColumnCount(int columnCount)
-{
-    columnCountLabel->setText(QString::number(columnCount));
-}
-
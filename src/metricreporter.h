@@ -4,6 +4,7 @@
 #include <QLabel>
 #include <QGroupBox>
 #include <QHBoxLayout>
+#include "documentmetrics.h"
 
 
 class MetricReporter : public QFrame
@@ -14,12 +15,13 @@ public:
     explicit MetricReporter(QWidget *parent = nullptr);
 
 public slots:
-    void updateWordCount(int wordCount);
-    void updateCharCount(int charCount);
-    void updateLineCount(int current, int total);
-    void updateColumnCount(int columnCount);
+    void showMetrics(const DocumentMetrics &metrics);
 
 private:
+    // Последний показанный снимок; метка меняется, только если изменилось ее поле
+    DocumentMetrics shown;
+    bool hasShown = false;
+
     QLabel *wordLabel;
     QLabel *wordCountLabel;
     QLabel *lineLabel;
@@ -0,0 +1,356 @@
+#include "minimap.h"
+#include "editor.h"
+#include "tracer.h"
+#include <QPainter>
+#include <QPaintEvent>
+#include <QMouseEvent>
+#include <QTextBlock>
+#include <QTextLayout>
+#include <QtConcurrent/QtConcurrentRun>
+#include <algorithm>
+#include <climits>
+
+
+// Инициализирует миникарту для указанного редактора и подписывается на изменения его документа.
+Minimap::Minimap(Editor *editor) : QWidget(editor), editor(editor), document(editor->document())
+{
+    knownBlockCount = document->blockCount();
+    setCursor(Qt::PointingHandCursor);
+    connect(document, SIGNAL(contentsChange(int, int, int)), this, SLOT(on_contentsChange(int, int, int)));
+}
+
+
+/* Помечает все плитки устаревшими (например, после смены языка подсветки).
+   Перерисованы будут только видимые плитки.
+ */
+void Minimap::invalidateAll()
+{
+    invalidateTiles(0, INT_MAX, true);
+    update();
+}
+
+
+// Объем изображений плиток в байтах.
+qint64 Minimap::memoryUsage() const
+{
+    qint64 bytes = 0;
+    for (const Tile &tile : tiles)
+    {
+        bytes += tile.image.sizeInBytes();
+    }
+    return bytes;
+}
+
+
+/* Освобождает все готовые плитки (например, когда вкладка ушла в фон и превышен бюджет памяти).
+   Плитки, которые еще растеризуются, остаются: их результат ждет on_tileRendered.
+ */
+void Minimap::releaseTiles()
+{
+    for (auto it = tiles.begin(); it != tiles.end();)
+    {
+        if (it->pending)
+        {
+            ++it;
+        }
+        else
+        {
+            it = tiles.erase(it);
+        }
+    }
+}
+
+
+/* Вызывается на каждый contentsChange документа. Если количество блоков не изменилось,
+   устаревают только плитки измененных блоков. Иначе строки после правки сдвинулись,
+   и устаревают все плитки начиная с первой измененной.
+ */
+void Minimap::on_contentsChange(int position, int charsRemoved, int charsAdded)
+{
+    Q_UNUSED(charsRemoved)
+
+    int firstBlock = qMax(0, document->findBlock(position).blockNumber());
+    int blockCount = document->blockCount();
+
+    if (blockCount != knownBlockCount)
+    {
+        knownBlockCount = blockCount;
+        invalidateTiles(firstBlock / TILE_LINES, INT_MAX, true);
+    }
+    else
+    {
+        QTextBlock lastBlock = document->findBlock(position + charsAdded);
+        int lastBlockNumber = lastBlock.isValid() ? lastBlock.blockNumber() : blockCount - 1;
+        invalidateTiles(firstBlock / TILE_LINES, lastBlockNumber / TILE_LINES, false);
+    }
+
+    update();
+}
+
+
+/* Помечает плитки в диапазоне [firstTile, lastTile] устаревшими. Изображения сохраняются
+   до готовности новых, чтобы миникарта не мигала. forgetStates сбрасывает запомненные
+   состояния подсветки, когда строки плиток сдвинулись.
+ */
+void Minimap::invalidateTiles(int firstTile, int lastTile, bool forgetStates)
+{
+    for (auto it = tiles.begin(); it != tiles.end(); ++it)
+    {
+        if (it.key() >= firstTile && it.key() <= lastTile)
+        {
+            it->dirty = true;
+
+            if (forgetStates)
+            {
+                it->endState = -1;
+            }
+        }
+    }
+}
+
+
+/* Снимает содержимое устаревшей плитки и запускает ее растеризацию в пуле потоков.
+   Если состояние подсветки в конце плитки изменилось (например, открылся многострочный
+   комментарий), следующая плитка тоже устарела.
+ */
+void Minimap::requestTile(int index)
+{
+    Tile &tile = tiles[index];
+
+    if (!tile.dirty || tile.pending)
+    {
+        return;
+    }
+
+    int endState = -1;
+    TileSnapshot snapshot = snapshotTile(index, endState);
+    bool endStateChanged = tile.endState != -1 && tile.endState != endState;
+
+    tile.endState = endState;
+    tile.dirty = false;
+    tile.pending = true;
+
+    QFutureWatcher<QImage> *watcher = new QFutureWatcher<QImage>(this);
+    pendingRenders.insert(watcher, index);
+    connect(watcher, SIGNAL(finished()), this, SLOT(on_tileRendered()));
+    watcher->setFuture(QtConcurrent::run(&Minimap::renderTile, snapshot));
+
+    if (endStateChanged)
+    {
+        auto next = tiles.find(index + 1);
+        if (next != tiles.end())
+        {
+            next->dirty = true;
+        }
+    }
+}
+
+
+// Вызывается в потоке GUI, когда рабочий поток закончил растеризацию плитки.
+void Minimap::on_tileRendered()
+{
+    QFutureWatcher<QImage> *watcher = static_cast<QFutureWatcher<QImage>*>(sender());
+    int index = pendingRenders.take(watcher);
+
+    auto tile = tiles.find(index);
+    if (tile != tiles.end())
+    {
+        tile->pending = false;
+        tile->image = watcher->result();
+    }
+
+    watcher->deleteLater();
+    update();
+}
+
+
+/* Копирует текст и цвета подсветки строк плитки. Выполняется в потоке GUI, так как
+   документ не потокобезопасен; строки обрезаются до ширины миникарты.
+ */
+Minimap::TileSnapshot Minimap::snapshotTile(int index, int &endState) const
+{
+    TileSnapshot snapshot;
+    snapshot.tabWidth = Editor::NUM_CHARS_FOR_TAB;
+
+    QTextBlock block = document->findBlockByNumber(index * TILE_LINES);
+
+    for (int i = 0; i < TILE_LINES && block.isValid(); i++, block = block.next())
+    {
+        QString text = block.text().left(MINIMAP_WIDTH);
+        QVector<ColorRun> runs;
+
+        for (const QTextLayout::FormatRange &range : block.layout()->formats())
+        {
+            if (range.start < text.length() && range.format.hasProperty(QTextFormat::ForegroundBrush))
+            {
+                ColorRun run = { range.start, range.length, range.format.foreground().color().rgb() };
+                runs.append(run);
+            }
+        }
+
+        snapshot.lines.append(text);
+        snapshot.runs.append(runs);
+        endState = block.userState();
+    }
+
+    return snapshot;
+}
+
+
+/* Растеризует плитку: каждый непробельный символ - один пиксель ширины и LINE_HEIGHT - 1
+   пикселей высоты цвета его токена. Выполняется в рабочем потоке.
+ */
+QImage Minimap::renderTile(TileSnapshot snapshot)
+{
+    TraceScope trace("Minimap::renderTile", "render");
+    QImage image(MINIMAP_WIDTH, TILE_LINES * LINE_HEIGHT, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::transparent);
+
+    const QRgb plainTextColor = qRgb(150, 150, 150);
+
+    for (int line = 0; line < snapshot.lines.size(); line++)
+    {
+        const QString &text = snapshot.lines.at(line);
+        QVector<QRgb> colors(text.length(), plainTextColor);
+
+        for (const ColorRun &run : snapshot.runs.at(line))
+        {
+            int end = qMin(text.length(), run.start + run.length);
+            for (int i = run.start; i < end; i++)
+            {
+                colors[i] = run.color;
+            }
+        }
+
+        int column = 0;
+        for (int i = 0; i < text.length() && column < MINIMAP_WIDTH; i++)
+        {
+            QChar character = text.at(i);
+
+            if (character == '\t')
+            {
+                column = (column / snapshot.tabWidth + 1) * snapshot.tabWidth;
+                continue;
+            }
+
+            if (!character.isSpace())
+            {
+                for (int row = 0; row < LINE_HEIGHT - 1; row++)
+                {
+                    QRgb *pixels = reinterpret_cast<QRgb*>(image.scanLine(line * LINE_HEIGHT + row));
+                    pixels[column] = colors.at(i);
+                }
+            }
+
+            column++;
+        }
+    }
+
+    return image;
+}
+
+
+/* Возвращает номер строки, отображаемой в верхней части миникарты. Если документ не помещается
+   в миникарту, она прокручивается пропорционально прокрутке редактора.
+ */
+int Minimap::firstMinimapLine() const
+{
+    int totalLines = document->blockCount();
+    int minimapLines = height() / LINE_HEIGHT;
+
+    if (totalLines <= minimapLines)
+    {
+        return 0;
+    }
+
+    int scrollableLines = qMax(1, totalLines - editor->visibleLineCount());
+    qint64 firstLine = qint64(editor->firstVisibleLine()) * (totalLines - minimapLines) / scrollableLines;
+    return qBound(0, int(firstLine), totalLines - minimapLines);
+}
+
+
+// Рисует видимые плитки (запрашивая перерисовку устаревших) и рамку видимой области редактора.
+void Minimap::paintEvent(QPaintEvent *event)
+{
+    QPainter painter(this);
+    painter.fillRect(event->rect(), QColor(245, 245, 245));
+
+    int firstLine = firstMinimapLine();
+    int lastLine = qMin(document->blockCount() - 1, firstLine + height() / LINE_HEIGHT);
+    int firstTile = firstLine / TILE_LINES;
+    int lastTile = lastLine / TILE_LINES;
+
+    for (int index = firstTile; index <= lastTile; index++)
+    {
+        requestTile(index);
+
+        QImage image = tiles.value(index).image;
+        if (!image.isNull())
+        {
+            painter.drawImage(0, (index * TILE_LINES - firstLine) * LINE_HEIGHT, image);
+        }
+    }
+
+    evictDistantTiles(firstTile, lastTile);
+
+    int viewportTop = (editor->firstVisibleLine() - firstLine) * LINE_HEIGHT;
+    int viewportHeight = qMax(LINE_HEIGHT, editor->visibleLineCount() * LINE_HEIGHT);
+    painter.fillRect(QRect(0, viewportTop, width(), viewportHeight), QColor(0, 0, 0, 30));
+}
+
+
+// Освобождает изображения плиток, наиболее удаленных от видимой области, когда их больше MAX_CACHED_TILES.
+void Minimap::evictDistantTiles(int firstVisibleTile, int lastVisibleTile)
+{
+    QVector<QPair<int, int>> cached;
+
+    for (auto it = tiles.constBegin(); it != tiles.constEnd(); ++it)
+    {
+        if (!it->image.isNull())
+        {
+            int distance = qMax(firstVisibleTile - it.key(), it.key() - lastVisibleTile);
+            cached.append(qMakePair(distance, it.key()));
+        }
+    }
+
+    if (cached.size() <= MAX_CACHED_TILES)
+    {
+        return;
+    }
+
+    std::sort(cached.begin(), cached.end());
+
+    for (int i = MAX_CACHED_TILES; i < cached.size(); i++)
+    {
+        Tile &tile = tiles[cached.at(i).second];
+        tile.image = QImage();
+        tile.dirty = true;
+    }
+}
+
+
+// Переходит к строке под указанной точкой миникарты и центрирует ее в редакторе.
+void Minimap::jumpTo(int y)
+{
+    int line = qBound(0, firstMinimapLine() + y / LINE_HEIGHT, document->blockCount() - 1);
+    editor->goTo(line + 1);
+    editor->centerCursor();
+}
+
+
+void Minimap::mousePressEvent(QMouseEvent *event)
+{
+    if (event->button() == Qt::LeftButton)
+    {
+        jumpTo(event->pos().y());
+    }
+}
+
+
+void Minimap::mouseMoveEvent(QMouseEvent *event)
+{
+    if (event->buttons() & Qt::LeftButton)
+    {
+        jumpTo(event->pos().y());
+    }
+}
@@ -0,0 +1,88 @@
+#ifndef MINIMAP_H
+#define MINIMAP_H
+#include <QWidget>
+#include <QImage>
+#include <QHash>
+#include <QMap>
+#include <QVector>
+#include <QFutureWatcher>
+#include <QTextDocument>
+
+class Editor;
+
+
+/* Миникарта кода справа от редактора. Документ делится на плитки по TILE_LINES строк;
+   каждая плитка растеризуется в уменьшенное изображение в рабочем потоке из снимка текста
+   и цветов подсветки. После правки сбрасываются только плитки измененных блоков, а
+   перерисовываются лишь видимые плитки, поэтому стоимость не зависит от размера документа.
+ */
+class Minimap : public QWidget
+{
+    Q_OBJECT
+
+public:
+    Minimap(Editor *editor);
+
+    qint64 memoryUsage() const;
+    void releaseTiles();
+
+    const static int MINIMAP_WIDTH = 100;
+    const static int LINE_HEIGHT = 2;
+    const static int TILE_LINES = 128;
+    const static int MAX_CACHED_TILES = 64;
+
+    // Цветной отрезок строки, взятый из форматов подсветки
+    struct ColorRun
+    {
+        int start;
+        int length;
+        QRgb color;
+    };
+
+    // Все, что нужно рабочему потоку для растеризации плитки, без обращений к документу
+    struct TileSnapshot
+    {
+        QVector<QString> lines;
+        QVector<QVector<ColorRun>> runs;
+        int tabWidth;
+    };
+
+public slots:
+    void invalidateAll();
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+    void mouseMoveEvent(QMouseEvent *event) override;
+
+private slots:
+    void on_contentsChange(int position, int charsRemoved, int charsAdded);
+    void on_tileRendered();
+
+private:
+    struct Tile
+    {
+        QImage image;
+        int endState = -1;         // userState последнего блока плитки на момент снимка
+        bool dirty = true;
+        bool pending = false;
+    };
+
+    int firstMinimapLine() const;
+    void invalidateTiles(int firstTile, int lastTile, bool forgetStates);
+    void requestTile(int index);
+    TileSnapshot snapshotTile(int index, int &endState) const;
+    void evictDistantTiles(int firstVisibleTile, int lastVisibleTile);
+    void jumpTo(int y);
+
+    static QImage renderTile(TileSnapshot snapshot);
+
+    Editor *editor;
+    QTextDocument *document;
+    int knownBlockCount;
+
+    QHash<int, Tile> tiles;
+    QMap<QFutureWatcher<QImage>*, int> pendingRenders;
+};
+
+#endif // MINIMAP_H
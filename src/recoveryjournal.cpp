@@ -0,0 +1,388 @@
+#include "recoveryjournal.h"
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QTextStream>
+#include <QThreadPool>
+#include <QUuid>
+#include <QtConcurrent/QtConcurrentRun>
+#include <QtDebug>
+
+
+namespace
+{
+    // Один поток на все журналы, поэтому записи журнала не обгоняют друг друга.
+    // При выходе деструктор пула дожидается удаления журналов закрытых вкладок
+    struct JournalPool : public QThreadPool
+    {
+        JournalPool() { setMaxThreadCount(1); }
+    };
+
+    QThreadPool *journalPool()
+    {
+        static JournalPool pool;
+        return &pool;
+    }
+
+
+    // Читает файл вкладки так же, как MainWindow::openFile.
+    bool readFile(const QString &filePath, QString &text)
+    {
+        QFile file(filePath);
+        if (!file.open(QIODevice::ReadOnly | QFile::Text))
+        {
+            return false;
+        }
+
+        QTextStream in(&file);
+        text = in.readAll();
+        return true;
+    }
+}
+
+
+RecoveryJournal::RecoveryJournal(QObject *parent) : QObject(parent),
+    id(QString::fromLatin1(QUuid::createUuid().toRfc4122().toHex()))
+{
+    lock.reset(new QLockFile(lockPath(id)));
+    lock->setStaleLockTime(0);
+
+    flushTimer = new QTimer(this);
+    flushTimer->setSingleShot(true);
+    flushTimer->setInterval(FLUSH_INTERVAL_MS);
+    connect(flushTimer, SIGNAL(timeout()), this, SLOT(flush()));
+}
+
+
+// Вкладка закрыта: ее несохраненные правки больше не нужны.
+RecoveryJournal::~RecoveryJournal()
+{
+    discard();
+}
+
+
+// Начинает журнал, основа которого - файл filePath на диске (пустой текст для безымянной вкладки).
+void RecoveryJournal::startFromFile(const QString &filePath)
+{
+    restart(filePath, QString());
+}
+
+
+// Начинает журнал, основа которого - снимок text (например, восстановленный текст).
+void RecoveryJournal::startFromSnapshot(const QString &text, const QString &filePath)
+{
+    restart(filePath, text.isNull() ? QString("") : text);
+}
+
+
+/* Дописывает правку в буфер. Вызывается на каждый contentsChange, поэтому здесь нет
+   обращений к диску: буфер уходит в фоновый поток раз в FLUSH_INTERVAL_MS.
+ */
+void RecoveryJournal::append(int position, int charsRemoved, const QString &inserted)
+{
+    QDataStream stream(&pending.records, QIODevice::WriteOnly | QIODevice::Append);
+    stream.setVersion(STREAM_VERSION);
+    stream << qint32(position) << qint32(charsRemoved) << inserted;
+
+    journalBytes += 2 * sizeof(qint32) + sizeof(quint32) + inserted.size() * qint64(sizeof(QChar));
+    scheduleFlush();
+}
+
+
+/* Заменяет основу журнала снимком текущего текста: записи до этого момента больше не нужны.
+   Снимок сжимается и записывается в фоновом потоке.
+ */
+void RecoveryJournal::compact(const QString &text)
+{
+    if (active)
+    {
+        restart(basePath, text);
+    }
+}
+
+
+// Удаляет журнал: документ сохранен или вернулся к сохраненному состоянию.
+void RecoveryJournal::discard()
+{
+    if (!active)
+    {
+        return;
+    }
+
+    active = false;
+    journalBytes = 0;
+    pending = Batch();
+    pending.removeFiles = true;
+    flush();
+}
+
+
+void RecoveryJournal::restart(const QString &filePath, const QString &snapshot)
+{
+    active = true;
+    generation++;
+    journalBytes = 0;
+    basePath = filePath;
+
+    pending.restart = true;
+    pending.generation = generation;
+    pending.filePath = filePath;
+    pending.snapshot = snapshot;
+    pending.records.clear();
+    scheduleFlush();
+}
+
+
+void RecoveryJournal::scheduleFlush()
+{
+    if (!flushTimer->isActive())
+    {
+        flushTimer->start();
+    }
+}
+
+
+// Отдает накопленную работу фоновому потоку.
+void RecoveryJournal::flush()
+{
+    flushTimer->stop();
+
+    if (pending.isEmpty())
+    {
+        return;
+    }
+
+    QtConcurrent::run(journalPool(), &RecoveryJournal::write, pending, id, lock);
+    pending = Batch();
+}
+
+
+QString RecoveryJournal::directory()
+{
+    static const QString path = QDir(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation)).filePath("recovery");
+    return path;
+}
+
+
+QString RecoveryJournal::journalPath(const QString &id)
+{
+    return QDir(directory()).filePath(id + ".journal");
+}
+
+
+QString RecoveryJournal::snapshotPath(const QString &id)
+{
+    return QDir(directory()).filePath(id + ".snapshot");
+}
+
+
+QString RecoveryJournal::lockPath(const QString &id)
+{
+    return QDir(directory()).filePath(id + ".lock");
+}
+
+
+/* Выполняется в фоновом потоке. Новая основа пишется раньше заголовка журнала, который на нее
+   ссылается: если процесс упадет между ними, findRecoverable увидит более новый снимок и возьмет его.
+ */
+void RecoveryJournal::write(const Batch &batch, const QString &id, QSharedPointer<QLockFile> lock)
+{
+    if (batch.removeFiles)
+    {
+        QFile::remove(journalPath(id));
+        QFile::remove(snapshotPath(id));
+        lock->unlock();
+        return;
+    }
+
+    if (batch.restart)
+    {
+        QDir().mkpath(directory());
+        if (!lock->isLocked())
+        {
+            lock->tryLock(0);
+        }
+
+        bool fromSnapshot = !batch.snapshot.isNull();
+        if (fromSnapshot)
+        {
+            QSaveFile snapshot(snapshotPath(id));
+            if (snapshot.open(QIODevice::WriteOnly))
+            {
+                QDataStream stream(&snapshot);
+                stream.setVersion(STREAM_VERSION);
+                stream << SNAPSHOT_MAGIC << qint32(batch.generation) << qCompress(batch.snapshot.toUtf8(), COMPRESSION_LEVEL);
+                snapshot.commit();
+            }
+        }
+
+        // Размер и время изменения файла-основы: если файл изменится до восстановления, правки к нему не применятся
+        QFileInfo base(batch.filePath);
+        bool hasBaseFile = !fromSnapshot && !batch.filePath.isEmpty() && base.exists();
+
+        QFile journal(journalPath(id));
+        if (!journal.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        {
+            return;
+        }
+
+        QDataStream stream(&journal);
+        stream.setVersion(STREAM_VERSION);
+        stream << JOURNAL_MAGIC << FORMAT_VERSION << qint32(batch.generation) << batch.filePath << fromSnapshot
+               << (hasBaseFile ? base.size() : qint64(-1))
+               << (hasBaseFile ? base.lastModified().toMSecsSinceEpoch() : qint64(-1));
+        journal.write(batch.records);
+
+        if (!fromSnapshot)
+        {
+            QFile::remove(snapshotPath(id));
+        }
+        return;
+    }
+
+    QFile journal(journalPath(id));
+    if (journal.open(QIODevice::WriteOnly | QIODevice::Append))
+    {
+        journal.write(batch.records);
+    }
+}
+
+
+/* Читает заголовок журнала и текст его основы. Возвращает false, если основу восстановить нельзя:
+   файл изменился или пропал, снимок поврежден. Если снимок новее заголовка, все записи журнала
+   уже вошли в него, и поток журнала переводится в конец.
+ */
+bool RecoveryJournal::readBase(const QString &id, QDataStream &journal, Recovered &recovered)
+{
+    quint32 magic = 0;
+    qint32 version = 0, generation = 0;
+    bool fromSnapshot = false;
+    qint64 baseSize = -1, baseModified = -1;
+
+    journal >> magic >> version >> generation >> recovered.filePath >> fromSnapshot >> baseSize >> baseModified;
+    if (journal.status() != QDataStream::Ok || magic != JOURNAL_MAGIC || version != FORMAT_VERSION)
+    {
+        return false;
+    }
+
+    QFile snapshotFile(snapshotPath(id));
+    if (snapshotFile.open(QIODevice::ReadOnly))
+    {
+        QDataStream snapshot(&snapshotFile);
+        snapshot.setVersion(STREAM_VERSION);
+
+        quint32 snapshotMagic = 0;
+        qint32 snapshotGeneration = 0;
+        QByteArray compressed;
+        snapshot >> snapshotMagic >> snapshotGeneration >> compressed;
+
+        bool valid = snapshot.status() == QDataStream::Ok && snapshotMagic == SNAPSHOT_MAGIC;
+        if (valid && (snapshotGeneration > generation || (fromSnapshot && snapshotGeneration == generation)))
+        {
+            recovered.text = QString::fromUtf8(qUncompress(compressed));
+
+            if (snapshotGeneration > generation)
+            {
+                journal.device()->seek(journal.device()->size());
+            }
+            return true;
+        }
+    }
+
+    if (fromSnapshot)
+    {
+        return false;
+    }
+
+    if (recovered.filePath.isEmpty() || baseSize < 0)
+    {
+        recovered.text = QString("");
+        return recovered.filePath.isEmpty() || !QFileInfo::exists(recovered.filePath);
+    }
+
+    QFileInfo base(recovered.filePath);
+    if (base.size() != baseSize || base.lastModified().toMSecsSinceEpoch() != baseModified)
+    {
+        return false;
+    }
+
+    return readFile(recovered.filePath, recovered.text);
+}
+
+
+/* Находит журналы вкладок, чьи процессы завершились аварийно, и применяет их правки к основам.
+   Журналы, запертые живым процессом, пропускаются; журналы, которые нельзя восстановить, удаляются.
+   Запись, оборванная на середине, отбрасывается.
+ */
+QVector<RecoveryJournal::Recovered> RecoveryJournal::findRecoverable()
+{
+    QVector<Recovered> recovered;
+    QDir recoveryDirectory(directory());
+
+    for (const QFileInfo &journalInfo : recoveryDirectory.entryInfoList(QStringList("*.journal"), QDir::Files))
+    {
+        QString id = journalInfo.completeBaseName();
+        QLockFile journalLock(lockPath(id));
+        journalLock.setStaleLockTime(0);
+
+        if (!journalLock.tryLock(0))
+        {
+            continue;
+        }
+
+        QFile journalFile(journalInfo.filePath());
+        if (!journalFile.open(QIODevice::ReadOnly))
+        {
+            continue;
+        }
+
+        QDataStream journal(&journalFile);
+        journal.setVersion(STREAM_VERSION);
+
+        Recovered entry;
+        entry.id = id;
+
+        if (!readBase(id, journal, entry))
+        {
+            qWarning().noquote() << "recovery: base of" << journalInfo.fileName() << "changed or is missing, discarding it";
+            remove(id);
+            continue;
+        }
+
+        while (!journal.atEnd())
+        {
+            qint32 position = 0, charsRemoved = 0;
+            QString inserted;
+            journal >> position >> charsRemoved >> inserted;
+
+            if (journal.status() != QDataStream::Ok)
+            {
+                break;
+            }
+
+            // Длины из contentsChange могут захватывать завершающий разделитель документа
+            position = qBound(0, int(position), entry.text.size());
+            entry.text.replace(position, qBound(0, int(charsRemoved), entry.text.size() - position), inserted);
+        }
+
+        // selectedText разделяет строки U+2029; сохранение (toPlainText) пишет '\n' и обычные пробелы
+        entry.text.replace(QChar::ParagraphSeparator, '\n');
+        entry.text.replace(QChar::Nbsp, ' ');
+        recovered.append(entry);
+    }
+
+    return recovered;
+}
+
+
+// Удаляет файлы восстановленного (или отклоненного) журнала.
+void RecoveryJournal::remove(const QString &id)
+{
+    QtConcurrent::run(journalPool(), [id]() {
+        QFile::remove(journalPath(id));
+        QFile::remove(snapshotPath(id));
+    });
+}
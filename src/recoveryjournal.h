@@ -0,0 +1,94 @@
+#ifndef RECOVERYJOURNAL_H
+#define RECOVERYJOURNAL_H
+#include <QObject>
+#include <QByteArray>
+#include <QDataStream>
+#include <QLockFile>
+#include <QSharedPointer>
+#include <QString>
+#include <QTimer>
+#include <QVector>
+
+
+/* Журнал восстановления несохраненной вкладки. Каждая правка документа (позиция, длина удаленного,
+   вставленный текст) дописывается в конец файла журнала в каталоге данных приложения. Основа, к которой
+   применяются правки, - файл вкладки на диске в момент первой правки или снимок текста, которым
+   журнал заменяется при сжатии (compact). В потоке GUI правка только сериализуется в буфер; запись,
+   сжатие снимка и удаление файлов идут по порядку в одном фоновом потоке.
+   Пока вкладка жива, журнал заперт QLockFile, поэтому при следующем запуске предлагаются
+   только журналы аварийно завершенных процессов (findRecoverable).
+ */
+class RecoveryJournal : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Recovered
+    {
+        QString id;
+        QString filePath;                // пусто для безымянной вкладки
+        QString text;
+    };
+
+    RecoveryJournal(QObject *parent = nullptr);
+    ~RecoveryJournal() override;
+
+    inline bool isActive() const { return active; }
+    void startFromFile(const QString &filePath);
+    void startFromSnapshot(const QString &text, const QString &filePath);
+    void append(int position, int charsRemoved, const QString &inserted);
+    inline bool needsCompaction() const { return active && journalBytes >= COMPACT_AFTER_BYTES; }
+    void compact(const QString &text);
+    void discard();
+
+    static QVector<Recovered> findRecoverable();
+    static void remove(const QString &id);
+
+    const static int FLUSH_INTERVAL_MS = 1000;
+    const static int COMPACT_AFTER_BYTES = 1 << 20;
+    const static int COMPRESSION_LEVEL = 1;
+    const static quint32 JOURNAL_MAGIC = 0x5458524a;   // "TXRJ"
+    const static quint32 SNAPSHOT_MAGIC = 0x54585253;  // "TXRS"
+    const static qint32 FORMAT_VERSION = 1;
+    const static QDataStream::Version STREAM_VERSION = QDataStream::Qt_5_0;
+
+private slots:
+    void flush();
+
+private:
+    // Накопленная для фонового потока работа; применяется по порядку: удаление, новая основа, правки
+    struct Batch
+    {
+        bool removeFiles = false;
+        bool restart = false;            // начать журнал заново с новым заголовком
+        int generation = 0;
+        QString filePath;
+        QString snapshot;                // не null - основа журнала - этот снимок
+        QByteArray records;
+
+        inline bool isEmpty() const { return !removeFiles && !restart && records.isEmpty(); }
+    };
+
+    void restart(const QString &filePath, const QString &snapshot);
+    void scheduleFlush();
+
+    static QString directory();
+    static QString journalPath(const QString &id);
+    static QString snapshotPath(const QString &id);
+    static QString lockPath(const QString &id);
+    static void write(const Batch &batch, const QString &id, QSharedPointer<QLockFile> lock);
+    static bool readBase(const QString &id, QDataStream &journal, Recovered &recovered);
+
+    QString id;
+    QString basePath;
+    bool active = false;
+    int generation = 0;
+    qint64 journalBytes = 0;
+    Batch pending;
+    QTimer *flushTimer;
+
+    // Блокировка создается здесь, но захватывается и снимается только в фоновом потоке
+    QSharedPointer<QLockFile> lock;
+};
+
+#endif // RECOVERYJOURNAL_H
@@ -0,0 +1,318 @@
+#include "reindenter.h"
+#include <QtConcurrent/QtConcurrentMap>
+
+
+namespace
+{
+    // Кусок строк, обрабатываемый одним потоком
+    struct Chunk
+    {
+        int begin = 0;
+        int end = 0;
+        int netDepth[2] = {0, 0};              // суммарное изменение вложенности внутри куска...
+        bool exitsInComment[2] = {false, false};  // ...и состояние комментария после него, для обоих входных состояний
+        int carry = 0;         // вложенность перед первой строкой куска
+        bool entersInComment = false;
+        int spaceLines = 0;    // строки, отступ которых начинается с пробела
+        int tabLines = 0;      // строки, отступ которых начинается с табуляции
+        QVector<int> deltaCounts;  // сколько раз отступ вырос на столько колонок
+    };
+
+
+    QVector<Chunk> splitIntoChunks(int lineCount)
+    {
+        QVector<Chunk> chunks;
+
+        for (int begin = 0; begin < lineCount; begin += Reindenter::LINES_PER_CHUNK)
+        {
+            Chunk chunk;
+            chunk.begin = begin;
+            chunk.end = qMin(begin + Reindenter::LINES_PER_CHUNK, lineCount);
+            chunks.append(chunk);
+        }
+
+        return chunks;
+    }
+
+
+    int leadingWhitespaceLength(const QString &line)
+    {
+        int length = 0;
+        while (length < line.length() && (line.at(length) == ' ' || line.at(length) == '\t'))
+        {
+            length++;
+        }
+        return length;
+    }
+
+
+    // Ширина отступа в колонках; табуляция доводит ширину до следующей позиции табуляции.
+    int indentationWidth(const QString &line, int leadingLength, int tabWidth)
+    {
+        int width = 0;
+        for (int i = 0; i < leadingLength; i++)
+        {
+            width = line.at(i) == '\t' ? (width / tabWidth + 1) * tabWidth : width + 1;
+        }
+        return width;
+    }
+
+
+    QString makeIndentation(int width, int tabWidth, bool useSpaces)
+    {
+        if (useSpaces)
+        {
+            return QString(width, ' ');
+        }
+
+        return QString(width / tabWidth, '\t') + QString(width % tabWidth, ' ');
+    }
+
+
+    /* Формирует правку строки с новым отступом заданной ширины. Строки только из пробелов
+       становятся пустыми; при stripTrailing также удаляются пробелы в конце строки.
+     */
+    Reindenter::LineEdit makeEdit(const QString &line, int newWidth, int tabWidth, bool useSpaces, bool stripTrailing)
+    {
+        Reindenter::LineEdit edit;
+        edit.leadingLength = leadingWhitespaceLength(line);
+
+        if (edit.leadingLength == line.length())
+        {
+            edit.changed = !line.isEmpty();
+            return edit;
+        }
+
+        if (stripTrailing)
+        {
+            int end = line.length();
+            while (end > edit.leadingLength && (line.at(end - 1) == ' ' || line.at(end - 1) == '\t'))
+            {
+                end--;
+            }
+            edit.trailingLength = line.length() - end;
+        }
+
+        edit.indentation = makeIndentation(newWidth, tabWidth, useSpaces);
+        edit.changed = edit.trailingLength > 0 ||
+                       line.leftRef(edit.leadingLength) != edit.indentation;
+        return edit;
+    }
+}
+
+
+/* Считает изменение вложенности в строке и количество закрывающих разделителей в ее начале
+   (например, "} else {"). Разделители внутри строковых литералов и комментариев, в том числе
+   многострочных (inComment переносится на следующую строку), не учитываются.
+ */
+void Reindenter::scanNesting(const QString &line, QChar open, QChar close, bool &inComment, int &leadingClosers, int &net)
+{
+    leadingClosers = 0;
+    net = 0;
+    bool atLineStart = true;
+
+    scanCode(line, inComment, [&](int, QChar character) {
+        if (character == open)
+        {
+            net++;
+            atLineStart = false;
+        }
+        else if (character == close)
+        {
+            net--;
+            if (atLineStart)
+            {
+                leadingClosers++;
+            }
+        }
+        else if (!character.isSpace())
+        {
+            atLineStart = false;
+        }
+    });
+}
+
+
+/* Определяет стиль отступов документа. Пробелы или табуляции - по большинству отступленных строк.
+   Шаг отступа - самый частый прирост ширины отступа между соседними непустыми строками:
+   одна строка продолжения, выровненная по произвольной колонке, его не меняет. Приросты
+   считаются параллельно по кускам; на границе кусков один прирост теряется.
+ */
+Reindenter::IndentStyle Reindenter::detectStyle(const QVector<QString> &lines, int tabWidth)
+{
+    QVector<Chunk> chunks = splitIntoChunks(lines.size());
+
+    QtConcurrent::blockingMap(chunks, [&](Chunk &chunk) {
+        chunk.deltaCounts.fill(0, MAX_INDENT_UNIT + 1);
+        int previousWidth = -1;
+
+        for (int i = chunk.begin; i < chunk.end; i++)
+        {
+            const QString &line = lines.at(i);
+            int leadingLength = leadingWhitespaceLength(line);
+
+            // Пустые строки не задают уровень
+            if (leadingLength == line.length())
+            {
+                continue;
+            }
+
+            if (leadingLength > 0)
+            {
+                (line.at(0) == '\t' ? chunk.tabLines : chunk.spaceLines)++;
+            }
+
+            int width = indentationWidth(line, leadingLength, tabWidth);
+            int delta = width - previousWidth;
+            if (previousWidth >= 0 && delta > 0 && delta <= MAX_INDENT_UNIT)
+            {
+                chunk.deltaCounts[delta]++;
+            }
+            previousWidth = width;
+        }
+    });
+
+    QVector<int> deltaCounts(MAX_INDENT_UNIT + 1, 0);
+    int spaceLines = 0;
+    int tabLines = 0;
+
+    for (const Chunk &chunk : chunks)
+    {
+        spaceLines += chunk.spaceLines;
+        tabLines += chunk.tabLines;
+        for (int delta = 1; delta <= MAX_INDENT_UNIT; delta++)
+        {
+            deltaCounts[delta] += chunk.deltaCounts.at(delta);
+        }
+    }
+
+    IndentStyle style;
+    style.useSpaces = spaceLines > tabLines;
+    style.unit = tabWidth;
+
+    int mostFrequent = 0;
+    for (int delta = 1; delta <= MAX_INDENT_UNIT; delta++)
+    {
+        if (deltaCounts.at(delta) > mostFrequent)
+        {
+            mostFrequent = deltaCounts.at(delta);
+            style.unit = delta;
+        }
+    }
+
+    // Отступы с выравниванием по одному пробелу не дают надежного шага
+    if (style.unit < 2)
+    {
+        style.unit = tabWidth;
+    }
+
+    return style;
+}
+
+
+/* Переотступ по вложенности разделителей блоков (фигурных скобок для C, C++ и Java).
+   Вложенность строки зависит от того, начинается ли она внутри многострочного комментария,
+   поэтому первый параллельный проход считает суммарный сдвиг каждого куска для обоих входных
+   состояний комментария. Затем последовательная префиксная сумма по кускам (их немного) выбирает
+   настоящие состояние и перенос вложенности, и второй параллельный проход формирует отступы.
+ */
+QVector<Reindenter::LineEdit> Reindenter::reindentByNesting(const QVector<QString> &lines, QChar blockStart,
+                                                            QChar blockEnd, int tabWidth, const IndentStyle &style)
+{
+    int levelWidth = style.useSpaces ? style.unit : tabWidth;
+    QVector<LineEdit> edits(lines.size());
+    QVector<Chunk> chunks = splitIntoChunks(lines.size());
+
+    // Потоки пишут в непересекающиеся диапазоны через указатель, минуя detach() контейнера
+    LineEdit *editsData = edits.data();
+
+    QtConcurrent::blockingMap(chunks, [&](Chunk &chunk) {
+        for (int entry = 0; entry < 2; entry++)
+        {
+            bool inComment = entry == 1;
+            for (int i = chunk.begin; i < chunk.end; i++)
+            {
+                int leadingClosers = 0;
+                int net = 0;
+                scanNesting(lines.at(i), blockStart, blockEnd, inComment, leadingClosers, net);
+                chunk.netDepth[entry] += net;
+            }
+            chunk.exitsInComment[entry] = inComment;
+        }
+    });
+
+    int carry = 0;
+    bool inComment = false;
+    for (Chunk &chunk : chunks)
+    {
+        chunk.carry = carry;
+        chunk.entersInComment = inComment;
+        carry += chunk.netDepth[inComment];
+        inComment = chunk.exitsInComment[inComment];
+    }
+
+    QtConcurrent::blockingMap(chunks, [&](Chunk &chunk) {
+        int depth = chunk.carry;
+        bool lineInComment = chunk.entersInComment;
+
+        for (int i = chunk.begin; i < chunk.end; i++)
+        {
+            int leadingClosers = 0;
+            int net = 0;
+            scanNesting(lines.at(i), blockStart, blockEnd, lineInComment, leadingClosers, net);
+
+            int level = qMax(0, depth - leadingClosers);
+            editsData[i] = makeEdit(lines.at(i), level * levelWidth, tabWidth, style.useSpaces, true);
+            depth += net;
+        }
+    });
+
+    return edits;
+}
+
+
+/* Переотступ для языков без закрывающего разделителя (Python) и для документов без языка.
+   Каждый уровень шага style.unit (см. detectStyle) приводится к одной табуляции или, если документ
+   отступлен пробелами, к тому же числу пробелов; остаток ширины сохраняется как выравнивание.
+ */
+QVector<Reindenter::LineEdit> Reindenter::reindentByWidth(const QVector<QString> &lines, int tabWidth, const IndentStyle &style)
+{
+    QVector<LineEdit> edits(lines.size());
+    QVector<Chunk> chunks = splitIntoChunks(lines.size());
+    LineEdit *editsData = edits.data();
+    int levelWidth = style.useSpaces ? style.unit : tabWidth;
+
+    QtConcurrent::blockingMap(chunks, [&](Chunk &chunk) {
+        for (int i = chunk.begin; i < chunk.end; i++)
+        {
+            const QString &line = lines.at(i);
+            int width = indentationWidth(line, leadingWhitespaceLength(line), tabWidth);
+            int newWidth = (width / style.unit) * levelWidth + width % style.unit;
+            editsData[i] = makeEdit(line, newWidth, tabWidth, style.useSpaces, true);
+        }
+    });
+
+    return edits;
+}
+
+
+/* Преобразует отступы между табуляциями и пробелами, сохраняя их ширину.
+   Строки независимы, поэтому обрабатываются параллельно без переноса состояния.
+ */
+QVector<Reindenter::LineEdit> Reindenter::convertIndentation(const QVector<QString> &lines, int tabWidth, bool useSpaces)
+{
+    QVector<LineEdit> edits(lines.size());
+    QVector<Chunk> chunks = splitIntoChunks(lines.size());
+    LineEdit *editsData = edits.data();
+
+    QtConcurrent::blockingMap(chunks, [&](Chunk &chunk) {
+        for (int i = chunk.begin; i < chunk.end; i++)
+        {
+            const QString &line = lines.at(i);
+            int width = indentationWidth(line, leadingWhitespaceLength(line), tabWidth);
+            editsData[i] = makeEdit(line, width, tabWidth, useSpaces, false);
+        }
+    });
+
+    return edits;
+}
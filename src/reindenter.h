@@ -0,0 +1,99 @@
+#ifndef REINDENTER_H
+#define REINDENTER_H
+#include <QString>
+#include <QVector>
+#include <QChar>
+
+
+/* Вычисление отступов для всего документа. Строки обрабатываются параллельно кусками:
+   каждый кусок сначала считает свой суммарный сдвиг вложенности, затем префиксная сумма
+   по кускам дает начальную вложенность каждого куска, и отступы строк вычисляются снова параллельно.
+   Результат - список правок по строкам, который редактор применяет одной пакетной правкой.
+ */
+namespace Reindenter
+{
+    struct LineEdit
+    {
+        int leadingLength = 0;       // длина исходного отступа строки
+        int trailingLength = 0;      // длина удаляемых пробелов в конце строки
+        QString indentation;         // новый отступ строки
+        bool changed = false;
+    };
+
+    // Стиль отступов документа: чем отступает большинство строк и ширина одного уровня в колонках
+    struct IndentStyle
+    {
+        bool useSpaces = false;
+        int unit = 0;
+    };
+
+    /* Вызывает visit(index, character) для каждого символа строки кода: вне комментариев и вне
+       содержимого строковых литералов (открывающая кавычка передается). inComment - строка
+       начинается внутри многострочного комментария; на выходе - заканчивается ли она в нем.
+     */
+    template <typename Visitor>
+    void scanCode(const QString &line, bool &inComment, Visitor visit)
+    {
+        QChar quote;
+        int length = line.length();
+
+        for (int i = 0; i < length; i++)
+        {
+            QChar character = line.at(i);
+            bool hasNext = i + 1 < length;
+
+            if (inComment)
+            {
+                if (character == '*' && hasNext && line.at(i + 1) == '/')
+                {
+                    inComment = false;
+                    i++;
+                }
+                continue;
+            }
+
+            if (!quote.isNull())
+            {
+                if (character == '\\')
+                {
+                    i++;
+                }
+                else if (character == quote)
+                {
+                    quote = QChar();
+                }
+                continue;
+            }
+
+            if (character == '/' && hasNext && line.at(i + 1) == '/')
+            {
+                return;
+            }
+
+            if (character == '/' && hasNext && line.at(i + 1) == '*')
+            {
+                inComment = true;
+                i++;
+                continue;
+            }
+
+            if (character == '"' || character == '\'')
+            {
+                quote = character;
+            }
+            visit(i, character);
+        }
+    }
+
+    void scanNesting(const QString &line, QChar open, QChar close, bool &inComment, int &leadingClosers, int &net);
+    IndentStyle detectStyle(const QVector<QString> &lines, int tabWidth);
+    QVector<LineEdit> reindentByNesting(const QVector<QString> &lines, QChar blockStart, QChar blockEnd,
+                                        int tabWidth, const IndentStyle &style);
+    QVector<LineEdit> reindentByWidth(const QVector<QString> &lines, int tabWidth, const IndentStyle &style);
+    QVector<LineEdit> convertIndentation(const QVector<QString> &lines, int tabWidth, bool useSpaces);
+
+    const int LINES_PER_CHUNK = 16384;
+    const int MAX_INDENT_UNIT = 16;
+}
+
+#endif // REINDENTER_H
@@ -18,3 +18,15 @@ void SearchHistory::add(QString term, int cursorPositionBeforeFirstSearch, int f
     locations.second = firstFoundAt;
     searchHistory.insert(term, locations);
 }
+
+
+// Приблизительный объем истории в байтах: строки запросов и узлы карты.
+qint64 SearchHistory::memoryUsage() const
+{
+    qint64 bytes = 0;
+    for (auto it = searchHistory.constBegin(); it != searchHistory.constEnd(); ++it)
+    {
+        bytes += it.key().capacity() * qint64(sizeof(QChar)) + 48;
+    }
+    return bytes;
+}
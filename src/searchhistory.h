@@ -13,6 +13,7 @@ public:
     inline int cursorPositionBeforeFirstSearchFor(QString term) { return searchHistory[term].first; }
     inline int firstFoundAt(QString term){ return searchHistory[term].second; }
     inline QMap<QString, QPair<int, int>> *getSearchHistory() { return &searchHistory; }
+    qint64 memoryUsage() const;
 
 private:
     // This will only ever contain one entry at a time, for the current search "chain"
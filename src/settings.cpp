@@ -1,4 +1,29 @@
 #include "settings.h"
+#include <QCoreApplication>
+#include <QtConcurrent/QtConcurrentRun>
+
+
+// Загружает все сохраненные настройки в кэш.
+Settings::Settings()
+{
+    QSettings settings;
+    for (const QString &key : settings.allKeys())
+    {
+        cache.insert(key, settings.value(key));
+    }
+
+    // Таймер живет в потоке GUI и удаляется вместе с приложением; перед выходом остаток дописывается
+    QCoreApplication *app = QCoreApplication::instance();
+    flushTimer = new QTimer(app);
+    flushTimer->setSingleShot(true);
+    flushTimer->setInterval(FLUSH_DELAY_MS);
+    QObject::connect(flushTimer, &QTimer::timeout, [this]() { flush(); });
+
+    if (app)
+    {
+        QObject::connect(app, &QCoreApplication::aboutToQuit, [this]() { sync(); });
+    }
+}
 
 
 /* Возвращает синглтон Settings, к которому имеют доступ все части
@@ -11,16 +36,31 @@ Settings *Settings::instance()
 }
 
 
-// Простая обертка для setValue из QSettings.
+/* Меняет значение в кэше и откладывает запись на диск. Повторная запись того же
+   значения ничего не делает.
+ */
 void Settings::setValue(const QString &key, const QVariant &value)
 {
-    settings.setValue(key, value);
+    auto found = cache.constFind(key);
+    if (found != cache.constEnd() && found.value() == value)
+    {
+        return;
+    }
+
+    cache.insert(key, value);
+    pending.insert(key, value);
+
+    if (!flushTimer->isActive())
+    {
+        flushTimer->start();
+    }
 }
 
 
-// Обертка для value из QSettings.
-QVariant Settings::value(const QString &key, const QVariant &defaultValue) {
-    return settings.value(key, defaultValue);
+// Возвращает значение из кэша.
+QVariant Settings::value(const QString &key, const QVariant &defaultValue) const
+{
+    return cache.value(key, defaultValue);
 }
 
 
@@ -34,3 +74,50 @@ void Settings::apply(QVariant setting, std::function<void(QVariant)> handler)
         handler(setting);
     }
 }
+
+
+/* Отдает накопленные изменения фоновому потоку. Пока предыдущая пачка пишется,
+   новые изменения ждут следующего срабатывания таймера, чтобы записи не шли параллельно.
+ */
+void Settings::flush()
+{
+    if (pending.isEmpty())
+    {
+        return;
+    }
+
+    if (flushing.isRunning())
+    {
+        flushTimer->start();
+        return;
+    }
+
+    flushing = QtConcurrent::run(&Settings::write, pending);
+    pending.clear();
+}
+
+
+// Дожидается фоновой записи и синхронно записывает оставшиеся изменения.
+void Settings::sync()
+{
+    flushTimer->stop();
+    flushing.waitForFinished();
+
+    if (!pending.isEmpty())
+    {
+        write(pending);
+        pending.clear();
+    }
+}
+
+
+// Пишет пачку изменений. QSettings реентерабелен, поэтому у каждого вызова свой экземпляр.
+void Settings::write(const QHash<QString, QVariant> &batch)
+{
+    QSettings settings;
+    for (auto setting = batch.constBegin(); setting != batch.constEnd(); ++setting)
+    {
+        settings.setValue(setting.key(), setting.value());
+    }
+    settings.sync();
+}
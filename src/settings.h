@@ -3,22 +3,50 @@
 #include <QSettings>
 #include <QString>
 #include <QVariant>
+#include <QHash>
+#include <QFuture>
+#include <QTimer>
 
 
+/* Настройки приложения. Все значения читаются из QSettings один раз при первом обращении
+   и дальше отдаются из памяти, поэтому создание вкладки не обращается к диску. Изменения
+   копятся и раз в FLUSH_DELAY_MS записываются пачкой в фоновом потоке; sync дописывает
+   остаток синхронно (при выходе).
+ */
 class Settings
 {
 public:
     static Settings *instance();
     void setValue(const QString &key, const QVariant &value);
-    QVariant value(const QString &key, const QVariant &defaultValue = QVariant());
+    QVariant value(const QString &key, const QVariant &defaultValue = QVariant()) const;
+    inline bool contains(const QString &key) const { return cache.contains(key); }
     void apply(QVariant setting, std::function<void(QVariant)> handler);
 
+    // Типизированное чтение из кэша: defaultValue, если ключа нет
+    template <typename T>
+    T typedValue(const QString &key, const T &defaultValue) const
+    {
+        auto found = cache.constFind(key);
+        return found == cache.constEnd() ? defaultValue : qvariant_cast<T>(found.value());
+    }
+
+    void sync();
+
+    const static int FLUSH_DELAY_MS = 1000;
+
 // Singleton
 private:
-    Settings(){}
+    Settings();
     Settings(const Settings& other);
     Settings &operator=(const Settings& other);
-    QSettings settings;
+
+    void flush();
+    static void write(const QHash<QString, QVariant> &batch);
+
+    QHash<QString, QVariant> cache;
+    QHash<QString, QVariant> pending;
+    QTimer *flushTimer = nullptr;
+    QFuture<void> flushing;
 };
 
 #endif // Settings_H
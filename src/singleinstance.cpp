@@ -0,0 +1,131 @@
+#include "singleinstance.h"
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDir>
+#include <QLockFile>
+
+
+SingleInstance::SingleInstance(QObject *parent) : QObject(parent)
+{
+}
+
+
+// Имя сокета уникально для пользователя и приложения.
+QString SingleInstance::serverName()
+{
+    QByteArray owner = (QCoreApplication::applicationName() + QDir::homePath()).toUtf8();
+    return QCoreApplication::applicationName() + "-" +
+           QCryptographicHash::hash(owner, QCryptographicHash::Sha1).toHex().left(16);
+}
+
+
+/* Передает файлы запущенному экземпляру или, если его нет, начинает слушать сам. Возвращает true,
+   если файлы переданы и процессу нужно завершиться. Без замка два одновременных запуска могли
+   оба не дождаться forward, и второй удалял сокет, который первый только что начал слушать.
+   Если замок не удалось взять за LOCK_TIMEOUT_MS, продолжаем без него, а не ждем бесконечно.
+ */
+bool SingleInstance::forwardOrListen(const QStringList &filePaths)
+{
+    QLockFile lock(QDir(QDir::tempPath()).filePath(serverName() + ".lock"));
+    lock.tryLock(LOCK_TIMEOUT_MS);
+
+    if (forward(filePaths))
+    {
+        return true;
+    }
+
+    listen();
+    return false;
+}
+
+
+/* Передает файлы уже запущенному экземпляру. Возвращает false, если его нет
+   (или он не ответил за FORWARD_TIMEOUT_MS): тогда этот процесс становится основным.
+ */
+bool SingleInstance::forward(const QStringList &filePaths)
+{
+    QLocalSocket socket;
+    socket.connectToServer(serverName());
+
+    if (!socket.waitForConnected(FORWARD_TIMEOUT_MS))
+    {
+        return false;
+    }
+
+    QByteArray message;
+    QDataStream stream(&message, QIODevice::WriteOnly);
+    stream.setVersion(STREAM_VERSION);
+    stream << filePaths;
+
+    socket.write(message);
+    if (!socket.waitForBytesWritten(FORWARD_TIMEOUT_MS))
+    {
+        return false;
+    }
+
+    socket.disconnectFromServer();
+    return true;
+}
+
+
+/* Начинает принимать файлы от следующих запусков. Сокет, оставшийся от аварийно
+   завершенного процесса, удаляется, но только если к нему снова не удалось подключиться:
+   занятый экземпляр мог просто не ответить forward вовремя.
+ */
+bool SingleInstance::listen()
+{
+    server = new QLocalServer(this);
+    server->setSocketOptions(QLocalServer::UserAccessOption);
+    connect(server, SIGNAL(newConnection()), this, SLOT(on_newConnection()));
+
+    if (server->listen(serverName()))
+    {
+        return true;
+    }
+
+    if (server->serverError() != QAbstractSocket::AddressInUseError)
+    {
+        return false;
+    }
+
+    QLocalSocket probe;
+    probe.connectToServer(serverName());
+    if (probe.waitForConnected(FORWARD_TIMEOUT_MS))
+    {
+        return false;
+    }
+
+    QLocalServer::removeServer(serverName());
+    return server->listen(serverName());
+}
+
+
+void SingleInstance::on_newConnection()
+{
+    while (QLocalSocket *socket = server->nextPendingConnection())
+    {
+        connect(socket, &QLocalSocket::readyRead, this, [this, socket]() { readFiles(socket); });
+        connect(socket, &QLocalSocket::disconnected, socket, &QLocalSocket::deleteLater);
+    }
+}
+
+
+// Читает список файлов, когда он пришел целиком; до этого данные остаются в сокете.
+void SingleInstance::readFiles(QLocalSocket *socket)
+{
+    QDataStream stream(socket);
+    stream.setVersion(STREAM_VERSION);
+    stream.startTransaction();
+
+    QStringList filePaths;
+    stream >> filePaths;
+
+    if (!stream.commitTransaction())
+    {
+        return;
+    }
+
+    socket->disconnectFromServer();
+    emit filesReceived(filePaths);
+}
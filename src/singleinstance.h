@@ -0,0 +1,45 @@
+#ifndef SINGLEINSTANCE_H
+#define SINGLEINSTANCE_H
+#include <QObject>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QStringList>
+#include <QDataStream>
+
+
+/* Один процесс textr на пользователя. Первый запуск слушает локальный сокет (listen);
+   следующие передают ему свои файлы (forward) и завершаются, не создавая окна и не читая
+   настройки. Пути передаются абсолютными, потому что у процессов разные рабочие каталоги.
+   Одновременные запуски выполняют forward и listen по очереди (см. forwardOrListen).
+ */
+class SingleInstance : public QObject
+{
+    Q_OBJECT
+
+public:
+    SingleInstance(QObject *parent = nullptr);
+
+    bool forwardOrListen(const QStringList &filePaths);
+    bool forward(const QStringList &filePaths);
+    bool listen();
+
+    static QString serverName();
+
+    const static int FORWARD_TIMEOUT_MS = 1000;
+    const static int LOCK_TIMEOUT_MS = 5000;
+    const static QDataStream::Version STREAM_VERSION = QDataStream::Qt_5_0;
+
+signals:
+    // Пустой список - повторный запуск без файлов: окно нужно только поднять
+    void filesReceived(QStringList filePaths);
+
+private slots:
+    void on_newConnection();
+
+private:
+    void readFiles(QLocalSocket *socket);
+
+    QLocalServer *server = nullptr;
+};
+
+#endif // SINGLEINSTANCE_H
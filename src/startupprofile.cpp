@@ -0,0 +1,39 @@
+#include "startupprofile.h"
+#include <QtDebug>
+
+
+QElapsedTimer StartupProfile::clock;
+qint64 StartupProfile::firstPaintMs = -1;
+qint64 StartupProfile::interactiveMs = -1;
+
+
+// Вызывается в начале main, до создания QApplication.
+void StartupProfile::start()
+{
+    clock.start();
+    firstPaintMs = -1;
+    interactiveMs = -1;
+}
+
+
+// Запоминает время первой отрисовки; повторные вызовы ничего не делают.
+void StartupProfile::firstPaint()
+{
+    if (clock.isValid() && firstPaintMs < 0)
+    {
+        firstPaintMs = clock.elapsed();
+    }
+}
+
+
+// Запоминает время готовности к вводу и пишет оба замера в журнал.
+void StartupProfile::interactive()
+{
+    if (!clock.isValid() || interactiveMs >= 0)
+    {
+        return;
+    }
+
+    interactiveMs = clock.elapsed();
+    qInfo().noquote() << QString("startup: first paint=%1ms interactive=%2ms").arg(firstPaintMs).arg(interactiveMs);
+}
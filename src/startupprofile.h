@@ -0,0 +1,23 @@
+#ifndef STARTUPPROFILE_H
+#define STARTUPPROFILE_H
+#include <QElapsedTimer>
+
+
+/* Замер запуска приложения: от начала main до первой отрисовки редактора (time to first paint)
+   и до момента, когда после нее опустела очередь событий и окно отвечает на ввод
+   (time to interactive). Оба значения один раз пишутся в журнал приложения.
+ */
+class StartupProfile
+{
+public:
+    static void start();
+    static void firstPaint();
+    static void interactive();
+
+private:
+    static QElapsedTimer clock;
+    static qint64 firstPaintMs;
+    static qint64 interactiveMs;
+};
+
+#endif // STARTUPPROFILE_H
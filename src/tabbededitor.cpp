@@ -3,25 +3,146 @@
 #include <QFont>
 #include <QFontDialog>
 #include <QtDebug>
+#include <QApplication>
+#include <QScrollBar>
 
 // tabbededitor - нужен для работы с несколькими вкладками
 
 // Инициализирует этот TabbedEditor с одной вкладкой Editor.
 TabbedEditor::TabbedEditor(QWidget *parent) : QTabWidget(parent)
 {
+    dispatcher = new ActiveEditor(this);
+
+    relayoutTimer = new QTimer(this);
+    relayoutTimer->setInterval(IDLE_RELAYOUT_INTERVAL_MS);
+    connect(relayoutTimer, &QTimer::timeout, this, &TabbedEditor::relayoutNextBackgroundTab);
+
     add(new Editor());
     installEventFilter(this);
     setMovable(true);
+
+    // В разделенной вкладке активным становится вид, получивший фокус
+    connect(qApp, &QApplication::focusChanged, this, &TabbedEditor::on_focusChanged);
 }
 
 
 /* Добавляет указанный Editor в виде новой вкладки.
    tab - объект Editor, который нужно добавить в виде вкладки этого виджета
+   makeCurrent - переключиться ли на новую вкладку (false для вкладок, восстанавливаемых из сессии)
+ */
+void TabbedEditor::add(Editor *tab, bool makeCurrent)
+{
+    // Страница вкладки - QSplitter: основной редактор всегда первый, за ним виды разделения
+    QSplitter *page = new QSplitter();
+    page->setChildrenCollapsible(false);
+    page->addWidget(tab);
+
+    QTabWidget::addTab(page, tab->getFileName());
+    dispatcher->attach(tab);
+
+    if (makeCurrent)
+    {
+        QTabWidget::setCurrentWidget(page);
+    }
+}
+
+
+// Убирает вкладку и удаляет ее редактор вместе с видами разделения.
+void TabbedEditor::remove(Editor *tab)
+{
+    int index = indexOf(tab);
+
+    if (index < 0)
+    {
+        return;
+    }
+
+    QWidget *page = widget(index);
+    removeTab(index);
+    page->deleteLater();
+}
+
+
+// Возвращает индекс вкладки, которой принадлежит редактор или вид, или -1.
+int TabbedEditor::indexOf(Editor *tab) const
+{
+    return tab ? QTabWidget::indexOf(tab->primaryEditor()->parentWidget()) : -1;
+}
+
+
+void TabbedEditor::setCurrentWidget(Editor *tab)
+{
+    setCurrentIndex(indexOf(tab));
+}
+
+
+/* Разделяет текущую вкладку: добавляет вид того же документа со своими курсором и прокруткой.
+   orientation - Qt::Horizontal располагает виды рядом, Qt::Vertical - друг под другом.
+   Новый вид открывается на месте активного.
  */
-void TabbedEditor::add(Editor *tab)
+void TabbedEditor::split(Qt::Orientation orientation)
+{
+    Editor *tab = currentTab();
+    QSplitter *page = qobject_cast<QSplitter*>(currentWidget());
+
+    if (!tab || !page)
+    {
+        return;
+    }
+
+    Editor *source = dispatcher->editor() && dispatcher->editor()->primaryEditor() == tab ? dispatcher->editor() : tab;
+    Editor *view = new Editor(tab);
+    view->setFont(tab->getFont(), QFont::Monospace, true, Editor::NUM_CHARS_FOR_TAB);
+    dispatcher->attach(view);
+
+    page->setOrientation(orientation);
+    page->addWidget(view);
+    page->setSizes(QList<int>::fromVector(QVector<int>(page->count(), 1)));
+
+    view->setTextCursor(source->textCursor());
+    view->verticalScrollBar()->setValue(source->verticalScrollBar()->value());
+    view->setFocus();
+}
+
+
+// Закрывает вид разделения, в котором фокус (или последний вид, если фокус в основном редакторе).
+void TabbedEditor::closeSplit()
 {
-    QTabWidget::addTab(tab, tab->getFileName());
-    setCurrentWidget(tab);
+    Editor *tab = currentTab();
+
+    if (!tab || tab->splitViews().isEmpty())
+    {
+        return;
+    }
+
+    Editor *view = dispatcher->editor();
+    if (!view || view == tab || view->primaryEditor() != tab)
+    {
+        view = tab->splitViews().last();
+    }
+
+    delete view;
+    tab->setFocus();
+}
+
+
+// Страница вкладки - QSplitter, первый виджет которого - основной редактор.
+Editor *TabbedEditor::editorOf(QWidget *page)
+{
+    QSplitter *splitter = qobject_cast<QSplitter*>(page);
+    return splitter ? qobject_cast<Editor*>(splitter->widget(0)) : nullptr;
+}
+
+
+void TabbedEditor::on_focusChanged(QWidget *old, QWidget *now)
+{
+    Q_UNUSED(old)
+
+    Editor *view = qobject_cast<Editor*>(now);
+    if (view && view->primaryEditor() == currentTab())
+    {
+        dispatcher->setEditor(view);
+    }
 }
 
 
@@ -29,7 +150,7 @@ void TabbedEditor::add(Editor *tab)
  */
 Editor* TabbedEditor::currentTab() const
 {
-    return qobject_cast<Editor*>(widget(currentIndex()));
+    return editorOf(widget(currentIndex()));
 }
 
 
@@ -42,7 +163,7 @@ Editor* TabbedEditor::tabAt(int index) const
         return nullptr;
     }
 
-    return qobject_cast<Editor*>(widget(index));
+    return editorOf(widget(index));
 }
 
 
@@ -61,6 +182,34 @@ QVector<Editor*> TabbedEditor::tabs() const
 }
 
 
+// Возвращает все вкладки, кроме текущей.
+QVector<Editor*> TabbedEditor::backgroundTabs() const
+{
+    QVector<Editor*> background = tabs();
+    background.removeAll(currentTab());
+    return background;
+}
+
+
+/* Применяет отложенные шрифт и перенос к одной фоновой вкладке, чтобы раскладка многих
+   больших документов не блокировала окно целиком. Текущую вкладку раскладывает ее showEvent.
+   Таймер останавливается, когда отложенного форматирования не осталось.
+ */
+void TabbedEditor::relayoutNextBackgroundTab()
+{
+    for (Editor *tab : backgroundTabs())
+    {
+        if (tab->hasPendingFormat())
+        {
+            tab->applyPendingFormat();
+            return;
+        }
+    }
+
+    relayoutTimer->stop();
+}
+
+
 /* Возвращает вектор всех вкладок Editor, которые не сохранены.
  */
 QVector<Editor*> TabbedEditor::unsavedTabs() const
@@ -93,13 +242,17 @@ void TabbedEditor::promptFontSelection()
     QMessageBox::StandardButton tabSelection = Utility::promptYesOrNo(this, tr("Font change"),
                                                                       tr("Apply to all open and future tabs?"));
 
-    // Применить шрифт ко всем вкладкам
+    // Применить шрифт ко всем вкладкам: сразу только к текущей, фоновые раскладываются позже
     if (tabSelection == QMessageBox::Yes)
     {
-        for (Editor *tab : tabs())
+        currentTab()->setFont(newFont, QFont::Monospace, true, Editor::NUM_CHARS_FOR_TAB);
+
+        for (Editor *tab : backgroundTabs())
         {
-            tab->setFont(newFont, QFont::Monospace, true, Editor::NUM_CHARS_FOR_TAB);
+            tab->deferFont(newFont);
         }
+
+        relayoutTimer->start();
     }
 
     // Применить шрифт только к текущей вкладке
@@ -130,14 +283,17 @@ bool TabbedEditor::applyWordWrapping(bool shouldWrap)
     QMessageBox::StandardButton tabSelection = Utility::promptYesOrNo(this, tr("Word wrapping"),
                                                                       tr("Apply to all open and future tabs?"));
 
-    // Применить перенос слов ко всем вкладкам
+    // Применить перенос слов ко всем вкладкам: сразу только к текущей, фоновые раскладываются позже
     if (tabSelection == QMessageBox::Yes)
     {
-        for (Editor *tab : tabs())
+        currentTab()->toggleWrapMode(shouldWrap);
+
+        for (Editor *tab : backgroundTabs())
         {
-            tab->toggleWrapMode(shouldWrap);
+            tab->deferWrapMode(shouldWrap);
         }
 
+        relayoutTimer->start();
         return true;
     }
 
@@ -2,7 +2,10 @@
 #define TABBEDEDITOR_H
 #include <QTabWidget>
 #include <editor.h>
+#include "activeeditor.h"
 #include <QVector>
+#include <QSplitter>
+#include <QTimer>
 
 class TabbedEditor : public QTabWidget
 {
@@ -11,9 +14,16 @@ class TabbedEditor : public QTabWidget
 public:
 
     TabbedEditor(QWidget *parent = nullptr);
-    void add(Editor* tab);
+    void add(Editor* tab, bool makeCurrent = true);
+    void remove(Editor *tab);
+    int indexOf(Editor *tab) const;
+    void setCurrentWidget(Editor *tab);
+
+    void split(Qt::Orientation orientation);
+    void closeSplit();
 
     Editor *currentTab() const;
+    inline ActiveEditor *activeEditor() const { return dispatcher; }
     Editor *tabAt(int index) const;
     QVector<Editor*> tabs() const;
     int numTabs() const { return tabs().length(); }
@@ -23,8 +33,23 @@ public:
     bool applyWordWrapping(bool shouldWrap);
     bool applyAutoIndentation(bool shouldAutoIndent);
 
+    const static int IDLE_RELAYOUT_INTERVAL_MS = 200;
+
 protected:
     bool eventFilter(QObject* obj, QEvent* event) override;
+
+private slots:
+    void on_focusChanged(QWidget *old, QWidget *now);
+    void relayoutNextBackgroundTab();
+
+private:
+    static Editor *editorOf(QWidget *page);
+    QVector<Editor*> backgroundTabs() const;
+
+    ActiveEditor *dispatcher;
+
+    // Раскладывает по одной фоновой вкладке с отложенным форматированием за срабатывание
+    QTimer *relayoutTimer;
 };
 
 #endif // TABBEDEDITOR_H
@@ -0,0 +1,83 @@
+# Исходники приложения без main.cpp; подключаются и приложением, и бенчмарками (../benchmarks)
+
+INCLUDEPATH += $$PWD
+
+SOURCES += \
+    $$PWD/code_highlighters/highlighter.cpp \
+    $$PWD/code_highlighters/chighlighter.cpp \
+    $$PWD/code_highlighters/cpphighlighter.cpp \
+    $$PWD/code_highlighters/javahighlighter.cpp \
+    $$PWD/code_highlighters/pythonhighlighter.cpp \
+    $$PWD/mainwindow.cpp \
+    $$PWD/finddialog.cpp \
+    $$PWD/editor.cpp \
+    $$PWD/metricreporter.cpp \
+    $$PWD/settings.cpp \
+    $$PWD/utilityfunctions.cpp \
+    $$PWD/searchhistory.cpp \
+    $$PWD/gotodialog.cpp \
+    $$PWD/tabbededitor.cpp \
+    $$PWD/language.cpp \
+    $$PWD/clipboardmimedata.cpp \
+    $$PWD/identifierindex.cpp \
+    $$PWD/reindenter.cpp \
+    $$PWD/gutterrenderer.cpp \
+    $$PWD/minimap.cpp \
+    $$PWD/folding.cpp \
+    $$PWD/latencymonitor.cpp \
+    $$PWD/latencyoverlay.cpp \
+    $$PWD/tracer.cpp \
+    $$PWD/batch.cpp \
+    $$PWD/memoryview.cpp \
+    $$PWD/hibernatedtab.cpp \
+    $$PWD/activeeditor.cpp \
+    $$PWD/startupprofile.cpp \
+    $$PWD/singleinstance.cpp \
+    $$PWD/recoveryjournal.cpp \
+    $$PWD/linediff.cpp \
+    $$PWD/filewatcher.cpp
+
+HEADERS += \
+    $$PWD/code_highlighters/highlighter.h \
+    $$PWD/code_highlighters/chighlighter.h \
+    $$PWD/code_highlighters/cpphighlighter.h \
+    $$PWD/code_highlighters/javahighlighter.h \
+    $$PWD/code_highlighters/pythonhighlighter.h \
+    $$PWD/mainwindow.h \
+    $$PWD/documentmetrics.h \
+    $$PWD/finddialog.h \
+    $$PWD/editor.h \
+    $$PWD/linenumberarea.h \
+    $$PWD/metricreporter.h \
+    $$PWD/settings.h \
+    $$PWD/utilityfunctions.h \
+    $$PWD/searchhistory.h \
+    $$PWD/gotodialog.h \
+    $$PWD/tabbededitor.h \
+    $$PWD/language.h \
+    $$PWD/clipboardmimedata.h \
+    $$PWD/identifierindex.h \
+    $$PWD/reindenter.h \
+    $$PWD/gutterrenderer.h \
+    $$PWD/minimap.h \
+    $$PWD/folding.h \
+    $$PWD/latencymonitor.h \
+    $$PWD/latencyoverlay.h \
+    $$PWD/tracer.h \
+    $$PWD/batch.h \
+    $$PWD/memoryusage.h \
+    $$PWD/memoryview.h \
+    $$PWD/hibernatedtab.h \
+    $$PWD/activeeditor.h \
+    $$PWD/startupprofile.h \
+    $$PWD/singleinstance.h \
+    $$PWD/recoveryjournal.h \
+    $$PWD/linediff.h \
+    $$PWD/filewatcher.h
+
+FORMS += \
+        $$PWD/mainwindow.ui
+
+
+RESOURCES += \
+    $$PWD/resources.qrc
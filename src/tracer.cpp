@@ -0,0 +1,156 @@
+#include "tracer.h"
+#include <QThread>
+#include <QCoreApplication>
+#include <QFile>
+#include <QTextStream>
+#include <QMutexLocker>
+
+
+std::atomic<bool> Tracer::enabled(false);
+
+
+Tracer::Tracer()
+{
+    clock.start();
+}
+
+
+// Возвращает синглтон Tracer.
+Tracer *Tracer::instance()
+{
+    static Tracer singleton;
+    return &singleton;
+}
+
+
+void Tracer::setEnabled(bool enable)
+{
+    enabled.store(enable, std::memory_order_relaxed);
+}
+
+
+Tracer::ThreadSlot::~ThreadSlot()
+{
+    if (buffer != nullptr)
+    {
+        Tracer::instance()->releaseThreadBuffer(buffer);
+    }
+}
+
+
+/* Возвращает буфер вызывающего потока при первом обращении: буфер завершившегося потока,
+   если такой есть, иначе новый. Дальше указатель берется из thread_local без блокировок.
+ */
+Tracer::ThreadBuffer *Tracer::currentThreadBuffer()
+{
+    thread_local ThreadSlot slot;
+    ThreadBuffer *&buffer = slot.buffer;
+
+    if (buffer == nullptr)
+    {
+        QMutexLocker locker(&registryMutex);
+
+        if (!freeBuffers.isEmpty())
+        {
+            // Идентификатор переходит к новому потоку, как tid в ОС; старые события остаются в кольце
+            buffer = freeBuffers.takeLast();
+        }
+        else
+        {
+            buffer = new ThreadBuffer;
+            buffer->threadId = buffers.size() + 1;
+            buffer->events.resize(EVENTS_PER_THREAD);
+            buffers.append(buffer);
+        }
+
+        QThread *thread = QThread::currentThread();
+        if (QCoreApplication::instance() && thread == QCoreApplication::instance()->thread())
+        {
+            buffer->threadName = "GUI";
+        }
+        else
+        {
+            buffer->threadName = thread->objectName().isEmpty() ? QString("Worker %1").arg(buffer->threadId)
+                                                                 : thread->objectName();
+        }
+    }
+
+    return buffer;
+}
+
+
+// Возвращает буфер завершившегося потока для повторного использования.
+void Tracer::releaseThreadBuffer(ThreadBuffer *buffer)
+{
+    QMutexLocker locker(&registryMutex);
+    freeBuffers.append(buffer);
+}
+
+
+// Записывает событие в кольцевой буфер текущего потока, вытесняя самое старое.
+void Tracer::record(const char *name, const char *category, qint64 start, qint64 duration)
+{
+    ThreadBuffer *buffer = currentThreadBuffer();
+    quint64 index = buffer->written.load(std::memory_order_relaxed);
+
+    buffer->events[int(index % EVENTS_PER_THREAD)] = {name, category, start, duration};
+    buffer->written.store(index + 1, std::memory_order_release);
+}
+
+
+/* Записывает все буферы в файл в формате Chrome trace_event (JSON). Запись в буферы
+   во время экспорта не останавливается: события, которые писатель мог перезаписать,
+   пока мы копировали буфер, отбрасываются.
+ */
+bool Tracer::writeChromeTrace(const QString &filePath)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly | QFile::Text))
+    {
+        return false;
+    }
+
+    QTextStream out(&file);
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    bool first = true;
+
+    auto separator = [&first]() {
+        const char *text = first ? "" : ",\n";
+        first = false;
+        return text;
+    };
+
+    QMutexLocker locker(&registryMutex);
+
+    for (ThreadBuffer *buffer : buffers)
+    {
+        quint64 end = buffer->written.load(std::memory_order_acquire);
+        quint64 begin = end > quint64(EVENTS_PER_THREAD) ? end - EVENTS_PER_THREAD : 0;
+
+        QVector<Event> events;
+        events.reserve(int(end - begin));
+        for (quint64 index = begin; index < end; index++)
+        {
+            events.append(buffer->events.at(int(index % EVENTS_PER_THREAD)));
+        }
+
+        // Писатель мог перезаписать слоты всех опубликованных событий и еще одного, записываемого сейчас
+        quint64 endAfterCopy = buffer->written.load(std::memory_order_acquire) + 1;
+        quint64 firstIntact = endAfterCopy > quint64(EVENTS_PER_THREAD) ? endAfterCopy - EVENTS_PER_THREAD : 0;
+        int skipped = int(qMin(end, qMax(begin, firstIntact)) - begin);
+
+        out << separator() << QString("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%1,\"args\":{\"name\":\"%2\"}}")
+                              .arg(buffer->threadId).arg(buffer->threadName);
+
+        for (int i = skipped; i < events.size(); i++)
+        {
+            const Event &event = events.at(i);
+            out << separator() << QString("{\"name\":\"%1\",\"cat\":\"%2\",\"ph\":\"X\",\"pid\":1,\"tid\":%3,\"ts\":%4,\"dur\":%5}")
+                                  .arg(event.name).arg(event.category).arg(buffer->threadId)
+                                  .arg(event.start / 1000.0, 0, 'f', 3).arg(event.duration / 1000.0, 0, 'f', 3);
+        }
+    }
+
+    out << "\n]}\n";
+    return file.error() == QFile::NoError;
+}
@@ -0,0 +1,102 @@
+#ifndef TRACER_H
+#define TRACER_H
+#include <QElapsedTimer>
+#include <QString>
+#include <QVector>
+#include <QMutex>
+#include <atomic>
+
+
+/* Трассировка горячих участков для chrome://tracing (Perfetto). Каждый поток пишет события
+   в свой кольцевой буфер без блокировок: единственный писатель публикует индекс следующего
+   события через atomic, а экспорт копирует только те события, которые не могли быть перезаписаны
+   во время копирования. Мьютекс берется лишь при первой записи потока, при его завершении
+   и при экспорте. Буфер завершившегося потока достается следующему новому потоку, поэтому
+   пересоздаваемые потоки пула не копят по буферу на каждый поток.
+   Пока запись выключена, TraceScope стоит одну проверку флага.
+ */
+class Tracer
+{
+public:
+    // Законченное событие длительностью duration (тип "X" в формате trace_event)
+    struct Event
+    {
+        const char *name;
+        const char *category;
+        qint64 start;
+        qint64 duration;
+    };
+
+    static Tracer *instance();
+    static inline bool isEnabled() { return enabled.load(std::memory_order_relaxed); }
+    void setEnabled(bool enable);
+
+    inline qint64 now() const { return clock.nsecsElapsed(); }
+    void record(const char *name, const char *category, qint64 start, qint64 duration);
+    bool writeChromeTrace(const QString &filePath);
+
+    const static int EVENTS_PER_THREAD = 1 << 16;
+
+// Singleton
+private:
+    Tracer();
+    Tracer(const Tracer& other);
+    Tracer &operator=(const Tracer& other);
+
+    struct ThreadBuffer
+    {
+        int threadId;
+        QString threadName;
+        QVector<Event> events;
+        std::atomic<quint64> written{0};
+    };
+
+    // Держатель буфера в thread_local: при завершении потока возвращает буфер в freeBuffers
+    struct ThreadSlot
+    {
+        ThreadBuffer *buffer = nullptr;
+        ~ThreadSlot();
+    };
+
+    ThreadBuffer *currentThreadBuffer();
+    void releaseThreadBuffer(ThreadBuffer *buffer);
+
+    static std::atomic<bool> enabled;
+    QElapsedTimer clock;
+
+    /* Буферы живут до конца программы, чтобы события завершившихся потоков попали в экспорт,
+       пока их не перезапишет поток, которому буфер достался повторно
+     */
+    QMutex registryMutex;
+    QVector<ThreadBuffer*> buffers;
+    QVector<ThreadBuffer*> freeBuffers;
+};
+
+
+/* Замер участка кода на время жизни объекта. name и category должны быть строковыми литералами:
+       TraceScope trace("Editor::find", "search");
+ */
+class TraceScope
+{
+    Q_DISABLE_COPY(TraceScope)
+
+public:
+    inline TraceScope(const char *name, const char *category)
+        : name(name), category(category), start(Tracer::isEnabled() ? Tracer::instance()->now() : -1) {}
+
+    inline ~TraceScope()
+    {
+        if (start >= 0)
+        {
+            Tracer *tracer = Tracer::instance();
+            tracer->record(name, category, start, tracer->now() - start);
+        }
+    }
+
+private:
+    const char *name;
+    const char *category;
+    qint64 start;
+};
+
+#endif // TRACER_H
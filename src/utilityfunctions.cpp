@@ -2,6 +2,7 @@
 #include <QStack>
 #include <QtDebug>
 #include <QQueue>
+#include <cctype>
 
 
 
@@ -41,3 +42,39 @@ bool Utility::codeBlockNotClosed(QString context, QChar startDelimiter, QChar en
     return !codeBlockStartDelimiters.empty();
 }
 
+
+/* Возвращает количество слов в тексте: последовательностей буквенно-цифровых символов
+   Latin-1, разделенных пробельными символами. Используется и редактором, и пакетным режимом,
+   поэтому вместо накопления текущего слова хранится только признак "внутри слова".
+ */
+int Utility::countWords(const QString &text)
+{
+    int wordCount = 0;
+    bool insideWord = false;
+
+    for (QChar textCharacter : text)
+    {
+        // Преобразуем в unsigned char, чтобы избежать проблем с утверждениями в отладке
+        unsigned char character = static_cast<unsigned char>(textCharacter.toLatin1());
+
+        // Буквенно-цифровой символ продолжает слово
+        if (isalnum(character))
+        {
+            insideWord = true;
+        }
+        // Пробельный символ (включая новую строку) завершает слово
+        else if (isspace(character) && insideWord)
+        {
+            wordCount++;
+            insideWord = false;
+        }
+    }
+
+    // Например, если мы остановились на слове, которое всё ещё набирается, его нужно учесть
+    if (insideWord)
+    {
+        wordCount++;
+    }
+
+    return wordCount;
+}
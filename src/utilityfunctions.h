@@ -8,6 +8,7 @@ namespace Utility
 {
     QMessageBox::StandardButton promptYesOrNo(QWidget *parent, QString title, QString prompt);
     bool codeBlockNotClosed(QString context, QChar startDelimiter, QChar endDelimiter);
+    int countWords(const QString &text);
 }
 
 #endif // UTILITYFUNCTIONS_H
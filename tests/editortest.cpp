@@ -0,0 +1,156 @@
+#include "editortest.h"
+#include "editor.h"
+#include "clipboardmimedata.h"
+#include "linediff.h"
+#include <QtTest>
+#include <QDropEvent>
+#include <QMimeData>
+#include <QMenu>
+#include <QAction>
+#include <QClipboard>
+#include <QApplication>
+#include <QScopedPointer>
+#include <QTextCursor>
+
+
+namespace
+{
+    // Документ из одинаковых строк длиной не меньше length символов
+    QString repeatedLines(int length)
+    {
+        QString line = QString(99, 'x') + '\n';
+        return line.repeated(length / line.size() + 2);
+    }
+
+
+    // Пункт контекстного меню редактора по имени объекта стандартного меню ("edit-cut" и т. п.)
+    QAction *menuAction(QMenu *menu, const QString &name)
+    {
+        for (QAction *action : menu->actions())
+        {
+            if (action->objectName() == name)
+            {
+                return action;
+            }
+        }
+        return nullptr;
+    }
+}
+
+
+/* Перемещение перетаскиванием внутри редактора удаляет выделение до вставки данных броска.
+   Ленивые данные большого выделения должны к этому моменту уже хранить свой текст.
+ */
+void EditorTest::dropDetachesLazySelection()
+{
+    Editor editor;
+    QString text = repeatedLines(Editor::LAZY_CLIPBOARD_THRESHOLD);
+    editor.setPlainText(text);
+
+    QTextCursor selection(editor.document());
+    selection.setPosition(0);
+    selection.setPosition(Editor::LAZY_CLIPBOARD_THRESHOLD, QTextCursor::KeepAnchor);
+    editor.setTextCursor(selection);
+    QString dragged = text.left(Editor::LAZY_CLIPBOARD_THRESHOLD);
+
+    QScopedPointer<QMimeData> data(editor.createMimeDataFromSelection());
+    ClipboardMimeData *lazy = qobject_cast<ClipboardMimeData*>(data.data());
+    QVERIFY(lazy);
+    QVERIFY(!lazy->isDetached());
+
+    QDropEvent drop(QPointF(0, 0), Qt::MoveAction, data.data(), Qt::LeftButton, Qt::NoModifier);
+    editor.dropEvent(&drop);
+    QVERIFY(lazy->isDetached());
+
+    // Как обработчик броска при перемещении: исходный диапазон удаляется
+    QTextCursor source(editor.document());
+    source.setPosition(0);
+    source.setPosition(Editor::LAZY_CLIPBOARD_THRESHOLD, QTextCursor::KeepAnchor);
+    source.removeSelectedText();
+
+    QCOMPARE(data->text(), dragged);
+}
+
+
+/* Cut из контекстного меню сразу удаляет выделение, поэтому в буфер обмена должен попасть
+   уже готовый текст, а не ленивый диапазон удаленного фрагмента.
+ */
+void EditorTest::contextMenuCutKeepsClipboard()
+{
+    Editor editor;
+    QString text = repeatedLines(Editor::LAZY_CLIPBOARD_THRESHOLD);
+    editor.setPlainText(text);
+
+    QTextCursor selection(editor.document());
+    selection.setPosition(0);
+    selection.setPosition(Editor::LAZY_CLIPBOARD_THRESHOLD, QTextCursor::KeepAnchor);
+    editor.setTextCursor(selection);
+
+    QScopedPointer<QMenu> menu(editor.createContextMenu(QPoint()));
+    QAction *cut = menuAction(menu.data(), "edit-cut");
+    QVERIFY(cut);
+    cut->trigger();
+
+    QCOMPARE(editor.toPlainText(), text.mid(Editor::LAZY_CLIPBOARD_THRESHOLD));
+    QCOMPARE(QApplication::clipboard()->text(), text.left(Editor::LAZY_CLIPBOARD_THRESHOLD));
+}
+
+
+// Undo из контекстного меню меняет документ под ленивой копией; копия должна остаться прежней.
+void EditorTest::contextMenuUndoDetachesLazyCopy()
+{
+    Editor editor;
+    QString text = repeatedLines(Editor::LAZY_CLIPBOARD_THRESHOLD);
+    editor.setPlainText(text);
+
+    QTextCursor edit(editor.document());
+    edit.insertText("y");
+
+    QTextCursor selection(editor.document());
+    selection.setPosition(0);
+    selection.setPosition(Editor::LAZY_CLIPBOARD_THRESHOLD, QTextCursor::KeepAnchor);
+    editor.setTextCursor(selection);
+    QString copied = ("y" + text).left(Editor::LAZY_CLIPBOARD_THRESHOLD);
+    editor.copy();
+
+    QScopedPointer<QMenu> menu(editor.createContextMenu(QPoint()));
+    QAction *undo = menuAction(menu.data(), "edit-undo");
+    QVERIFY(undo);
+    undo->trigger();
+
+    QCOMPARE(editor.toPlainText(), text);
+    QCOMPARE(QApplication::clipboard()->text(), copied);
+}
+
+
+void EditorTest::applyHunksMatchesDiff_data()
+{
+    QTest::addColumn<QString>("before");
+    QTest::addColumn<QString>("after");
+
+    QTest::newRow("insert at end") << "a\nb" << "a\nb\nc";
+    QTest::newRow("insert at start") << "b\nc" << "a\nb\nc";
+    QTest::newRow("delete last line") << "a\nb\nc" << "a\nb";
+    QTest::newRow("delete first line") << "a\nb\nc" << "b\nc";
+    QTest::newRow("trailing newline removed") << "a\nb\n" << "a\nb";
+    QTest::newRow("trailing newline added") << "a\nb" << "a\nb\n";
+    QTest::newRow("replace middle") << "a\nb\nc" << "a\nx\ny\nc";
+    QTest::newRow("from empty") << "" << "a\nb";
+    QTest::newRow("to empty") << "a\nb" << "";
+}
+
+
+/* Перечитывание файла применяет к документу куски разности, а не заменяет текст целиком.
+   Результат должен совпасть с файлом, в том числе на краях документа.
+ */
+void EditorTest::applyHunksMatchesDiff()
+{
+    QFETCH(QString, before);
+    QFETCH(QString, after);
+
+    Editor editor;
+    editor.setPlainText(before);
+    editor.applyHunks(LineDiff::diff(editor.documentLines(), after.split('\n').toVector()));
+
+    QCOMPARE(editor.toPlainText(), after);
+}
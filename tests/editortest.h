@@ -0,0 +1,21 @@
+#ifndef EDITORTEST_H
+#define EDITORTEST_H
+#include <QObject>
+
+
+/* Поведенческие тесты редактора: пути, где ошибка молча портит текст пользователя
+   или данные буфера обмена.
+ */
+class EditorTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void dropDetachesLazySelection();
+    void contextMenuCutKeepsClipboard();
+    void contextMenuUndoDetachesLazyCopy();
+    void applyHunksMatchesDiff_data();
+    void applyHunksMatchesDiff();
+};
+
+#endif // EDITORTEST_H
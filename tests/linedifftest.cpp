@@ -0,0 +1,154 @@
+#include "linedifftest.h"
+#include "linediff.h"
+#include <QtTest>
+#include <QStringList>
+#include <random>
+
+
+namespace
+{
+    QVector<QString> linesOf(const QString &text)
+    {
+        return text.split('\n').toVector();
+    }
+
+
+    /* Применяет куски к старым строкам по порядку. consistent - newStart каждого куска совпал
+       с местом, куда его строки попали в результате.
+     */
+    QVector<QString> apply(const QVector<QString> &oldLines, const QVector<LineDiff::Hunk> &hunks, bool &consistent)
+    {
+        QVector<QString> result;
+        int next = 0;
+        consistent = true;
+
+        for (const LineDiff::Hunk &hunk : hunks)
+        {
+            consistent = consistent && hunk.oldStart >= next;
+            for (; next < hunk.oldStart && next < oldLines.size(); next++)
+            {
+                result.append(oldLines.at(next));
+            }
+
+            consistent = consistent && result.size() == hunk.newStart;
+            result += hunk.newLines;
+            next += hunk.oldCount;
+        }
+
+        for (; next < oldLines.size(); next++)
+        {
+            result.append(oldLines.at(next));
+        }
+
+        return result;
+    }
+}
+
+
+void LineDiffTest::roundTrip_data()
+{
+    QTest::addColumn<QString>("before");
+    QTest::addColumn<QString>("after");
+
+    QTest::newRow("identical") << "a\nb\nc" << "a\nb\nc";
+    QTest::newRow("insert at start") << "b\nc" << "a\nb\nc";
+    QTest::newRow("insert at end") << "a\nb" << "a\nb\nc";
+    QTest::newRow("delete first line") << "a\nb\nc" << "b\nc";
+    QTest::newRow("delete last line") << "a\nb\nc" << "a\nb";
+    QTest::newRow("replace middle") << "a\nb\nc" << "a\nx\ny\nc";
+    QTest::newRow("trailing newline removed") << "a\nb\n" << "a\nb";
+    QTest::newRow("trailing newline added") << "a\nb" << "a\nb\n";
+    QTest::newRow("from empty") << "" << "a\nb";
+    QTest::newRow("to empty") << "a\nb" << "";
+    QTest::newRow("repeated lines") << "x\nx\nx\nx" << "x\nx";
+    QTest::newRow("several hunks") << "a\nb\nc\nd\ne\nf" << "a\nB\nc\nd\nf\ng";
+}
+
+
+void LineDiffTest::roundTrip()
+{
+    QFETCH(QString, before);
+    QFETCH(QString, after);
+
+    QVector<QString> oldLines = linesOf(before);
+    QVector<LineDiff::Hunk> hunks = LineDiff::diff(oldLines, linesOf(after));
+
+    bool consistent = false;
+    QCOMPARE(QStringList(apply(oldLines, hunks, consistent).toList()).join('\n'), after);
+    QVERIFY(consistent);
+
+    if (before == after)
+    {
+        QVERIFY(hunks.isEmpty());
+    }
+}
+
+
+// Случайные правки над небольшим алфавитом строк: много совпадающих строк запутывают сопоставление.
+void LineDiffTest::randomRoundTrips()
+{
+    std::mt19937 generator(2024);
+    auto random = [&generator](int bound) { return int(generator() % quint32(bound)); };
+    const QStringList alphabet = {"a", "b", "c", "{", "}", ""};
+
+    for (int round = 0; round < 2000; round++)
+    {
+        QVector<QString> oldLines;
+        int oldSize = 1 + random(39);
+        for (int i = 0; i < oldSize; i++)
+        {
+            oldLines.append(alphabet.at(random(alphabet.size())));
+        }
+
+        QVector<QString> newLines = oldLines;
+        int edits = random(6);
+        for (int i = 0; i < edits; i++)
+        {
+            int position = random(newLines.size() + 1);
+            switch (random(3))
+            {
+                case 0:
+                    newLines.insert(position, alphabet.at(random(alphabet.size())));
+                    break;
+                case 1:
+                    if (position < newLines.size() && newLines.size() > 1)
+                    {
+                        newLines.remove(position);
+                    }
+                    break;
+                default:
+                    if (position < newLines.size())
+                    {
+                        newLines[position] = alphabet.at(random(alphabet.size()));
+                    }
+                    break;
+            }
+        }
+
+        bool consistent = false;
+        QVector<QString> result = apply(oldLines, LineDiff::diff(oldLines, newLines), consistent);
+        QVERIFY2(result == newLines && consistent, qPrintable(QString("round %1").arg(round)));
+    }
+}
+
+
+// Правки в начале и в конце большого текста не сливаются в один кусок на весь текст.
+void LineDiffTest::distantEditsGiveSeparateHunks()
+{
+    QVector<QString> oldLines;
+    for (int i = 0; i < 10000; i++)
+    {
+        oldLines.append(QString::number(i));
+    }
+
+    QVector<QString> newLines = oldLines;
+    newLines[10] = "first";
+    newLines[9990] = "second";
+
+    QVector<LineDiff::Hunk> hunks = LineDiff::diff(oldLines, newLines);
+    QCOMPARE(hunks.size(), 2);
+    QCOMPARE(hunks.at(0).oldStart, 10);
+    QCOMPARE(hunks.at(0).oldCount, 1);
+    QCOMPARE(hunks.at(1).oldStart, 9990);
+    QCOMPARE(hunks.at(1).newLines, QVector<QString>({"second"}));
+}
@@ -0,0 +1,20 @@
+#ifndef LINEDIFFTEST_H
+#define LINEDIFFTEST_H
+#include <QObject>
+
+
+/* Тесты построчной разности: куски, примененные к старой версии, должны давать новую
+   ровно, включая правки в начале и в конце и пустые версии.
+ */
+class LineDiffTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void roundTrip_data();
+    void roundTrip();
+    void randomRoundTrips();
+    void distantEditsGiveSeparateHunks();
+};
+
+#endif // LINEDIFFTEST_H
@@ -0,0 +1,27 @@
+#include "editortest.h"
+#include "linedifftest.h"
+#include "reindentertest.h"
+#include <QApplication>
+#include <QtTest>
+
+
+// Запускает все наборы тестов; код возврата ненулевой, если упал хотя бы один.
+int main(int argc, char *argv[])
+{
+    QApplication app(argc, argv);
+    app.setOrganizationName("Kerimov David, Slobodan Lelikov");
+    app.setApplicationName("TextrTests");
+
+    int failed = 0;
+
+    EditorTest editorTest;
+    failed += QTest::qExec(&editorTest, argc, argv);
+
+    LineDiffTest lineDiffTest;
+    failed += QTest::qExec(&lineDiffTest, argc, argv);
+
+    ReindenterTest reindenterTest;
+    failed += QTest::qExec(&reindenterTest, argc, argv);
+
+    return failed;
+}
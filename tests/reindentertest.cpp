@@ -0,0 +1,110 @@
+#include "reindentertest.h"
+#include "reindenter.h"
+#include <QtTest>
+
+
+namespace
+{
+    const int TAB_WIDTH = 4;
+
+    const Reindenter::IndentStyle TABS = {false, TAB_WIDTH};
+}
+
+
+// Строка продолжения, выровненная по произвольной колонке, не меняет шаг отступа.
+void ReindenterTest::detectsModalStep()
+{
+    QVector<QString> lines = {
+        "int f()",
+        "{",
+        "    if (x)",
+        "    {",
+        "        call(a,",
+        "             b);",
+        "    }",
+        "}"
+    };
+
+    Reindenter::IndentStyle style = Reindenter::detectStyle(lines, TAB_WIDTH);
+    QVERIFY(style.useSpaces);
+    QCOMPARE(style.unit, 4);
+}
+
+
+// Документ с отступом в два пробела остается с отступом в два пробела.
+void ReindenterTest::nestingKeepsSpaces()
+{
+    QVector<QString> lines = {
+        "void f() {",
+        "  int a;",
+        "  if (a) {",
+        "  b();",
+        "  }",
+        "}"
+    };
+
+    Reindenter::IndentStyle style = Reindenter::detectStyle(lines, TAB_WIDTH);
+    QVector<Reindenter::LineEdit> edits = Reindenter::reindentByNesting(lines, '{', '}', TAB_WIDTH, style);
+
+    QCOMPARE(edits.at(1).indentation, QString("  "));
+    QVERIFY(!edits.at(1).changed);
+    QCOMPARE(edits.at(3).indentation, QString("    "));
+    QVERIFY(edits.at(3).changed);
+    QCOMPARE(edits.at(4).indentation, QString("  "));
+    QCOMPARE(edits.at(5).indentation, QString(""));
+}
+
+
+void ReindenterTest::ignoresDelimitersInCommentsAndStrings()
+{
+    QVector<QString> lines = {
+        "void f() {",
+        "/* {",
+        "   } } */",
+        "char c = '{'; // }",
+        "const char *s = \"}\\\"}\";",
+        "}"
+    };
+
+    QVector<Reindenter::LineEdit> edits = Reindenter::reindentByNesting(lines, '{', '}', TAB_WIDTH, TABS);
+
+    QCOMPARE(edits.at(1).indentation, QString("\t"));
+    QCOMPARE(edits.at(3).indentation, QString("\t"));
+    QCOMPARE(edits.at(4).indentation, QString("\t"));
+    QCOMPARE(edits.at(5).indentation, QString(""));
+}
+
+
+// Многострочный комментарий, пересекающий границу кусков, учитывается префиксным проходом.
+void ReindenterTest::carriesCommentAcrossChunks()
+{
+    QVector<QString> lines = {"void f() {", "/*"};
+    while (lines.size() < Reindenter::LINES_PER_CHUNK + 10)
+    {
+        lines.append("{");
+    }
+    lines << "*/" << "x();" << "}";
+
+    QVector<Reindenter::LineEdit> edits = Reindenter::reindentByNesting(lines, '{', '}', TAB_WIDTH, TABS);
+
+    QCOMPARE(edits.at(lines.size() - 2).indentation, QString("\t"));
+    QCOMPARE(edits.at(lines.size() - 1).indentation, QString(""));
+}
+
+
+// Без разделителей уровни шага приводятся к табуляциям, а остаток ширины остается выравниванием.
+void ReindenterTest::widthKeepsAlignment()
+{
+    QVector<QString> lines = {
+        "def f():",
+        "    if x:",
+        "        g(a,",
+        "          b)"
+    };
+
+    QVector<Reindenter::LineEdit> edits = Reindenter::reindentByWidth(lines, TAB_WIDTH, TABS);
+
+    QCOMPARE(edits.at(1).indentation, QString("\t"));
+    QCOMPARE(edits.at(2).indentation, QString("\t\t"));
+    QCOMPARE(edits.at(3).indentation, QString("\t\t  "));
+}
@@ -0,0 +1,21 @@
+#ifndef REINDENTERTEST_H
+#define REINDENTERTEST_H
+#include <QObject>
+
+
+/* Тесты переотступа: стиль документа (пробелы или табуляции, шаг) сохраняется, а разделители
+   в комментариях и строковых литералах не меняют вложенность, в том числе на границе кусков.
+ */
+class ReindenterTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void detectsModalStep();
+    void nestingKeepsSpaces();
+    void ignoresDelimitersInCommentsAndStrings();
+    void carriesCommentAcrossChunks();
+    void widthKeepsAlignment();
+};
+
+#endif // REINDENTERTEST_H
@@ -0,0 +1,24 @@
+QT       += core gui printsupport concurrent network testlib
+
+greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
+
+TARGET = TextrTests
+TEMPLATE = app
+
+DEFINES += QT_DEPRECATED_WARNINGS
+CONFIG += c++11 console testcase
+CONFIG -= app_bundle
+
+
+include(../src/textr.pri)
+
+SOURCES += \
+    editortest.cpp \
+    linedifftest.cpp \
+    main.cpp \
+    reindentertest.cpp
+
+HEADERS += \
+    editortest.h \
+    linedifftest.h \
+    reindentertest.h